@@ -0,0 +1,86 @@
+#!/bin/sh
+# Compares the time of checking clauses with the AVX2 clause evaluator (the
+# default if the CPU supports AVX2) and with the scalar evaluator.
+usage () {
+cat <<END
+usage: bench/evaluator.sh [ -h | --help ] [ <clauses> [ <runs> ] ]
+
+Generates with 'bench/generate' formulas with '<clauses>' short clauses
+of size two and three (default '8000000') over one million variables
+(where the values fit into the cache) and over 16 million variables, and
+a formula with the same number of literals in clauses of size 32 over 16
+million variables in '\$BENCH_DIR' (default 'bench/data').  Existing
+benchmarks are reused.
+Each formula is checked '<runs>' times (default '5') once with the
+default clause evaluator and once with '--scalar'.  The best check time
+(without parsing) of each is reported together with the speedup.
+END
+}
+die () {
+  echo "bench/evaluator.sh: error: $*" 1>&2
+  exit 1
+}
+msg () {
+  echo "[bench/evaluator.sh] $*"
+}
+case "$1" in
+  -h|--help) usage; exit 0;;
+esac
+cd `dirname $0`/.. || exit 1
+binary=./dimocheck
+generate=./bench/generate
+[ -f $binary ] || die "could not find 'dimocheck' (run 'make' first)"
+[ -f $generate ] || die "could not find '$generate' (run 'make bench/generate')"
+clauses=${1:-8000000}
+runs=${2:-5}
+dir=${BENCH_DIR:-bench/data}
+mkdir -p $dir || die "could not create '$dir'"
+tmp=`mktemp -d` || die "could not create temporary directory"
+trap "rm -rf $tmp" 0
+if grep -q avx2 /proc/cpuinfo 2>/dev/null
+then
+  evaluator=avx2
+else
+  evaluator=default
+fi
+generate () {
+  name=$1
+  shift
+  if [ ! -f $dir/$name.info ]
+  then
+    msg "generating '$name'"
+    $generate "$@" $dir/$name.cnf $dir/$name.sol > $dir/$name.info || \
+      die "generating '$name' failed"
+  fi
+}
+best () {
+  tail -n +2 $1 | tr -d '"' | cut -d, -f6 | sort -n | head -1
+}
+bench () {
+  name=$1
+  rm -f $tmp/manifest
+  i=0
+  while [ $i -lt $runs ]
+  do
+    echo "$dir/$name.cnf $dir/$name.sol" >> $tmp/manifest
+    i=`expr $i + 1`
+  done
+  for option in "" --scalar
+  do
+    $binary --manifest $tmp/manifest --results $tmp/results$option $option \
+      -q 1>/dev/null || die "checking '$name' failed"
+  done
+  echo "$name `best $tmp/results` `best $tmp/results--scalar`" | awk '{
+    printf "%-20s %8.3f s %8.3f s %8.2fx\n", $1, $2, $3, $2 ? $3 / $2 : 0 }'
+}
+generate short-$clauses-1M --clauses $clauses --variables 1000000 \
+  --sizes 2:1,3:1
+generate short-$clauses-16M --clauses $clauses --variables 16000000 \
+  --sizes 2:1,3:1
+generate wide-$clauses-16M --clauses `expr $clauses \* 5 / 64` \
+  --variables 16000000 --sizes 32:1
+msg "best check time of $runs runs"
+printf "%-20s %10s %10s %9s\n" benchmark $evaluator scalar speedup
+bench short-$clauses-1M
+bench short-$clauses-16M
+bench wide-$clauses-16M
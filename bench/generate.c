@@ -0,0 +1,324 @@
+// clang-format off
+static const char * usage =
+"usage: generate [ <option> ... ] <dimacs> <solution>\n"
+"\n"
+"-h | --help        print this command line option summary\n"
+"     --size <bytes>[K|M|G]\n"
+"                   approximate size of the DIMACS file (default '1M')\n"
+"     --clauses <clauses>\n"
+"                   number of clauses (instead of '--size')\n"
+"     --variables <variables>\n"
+"                   number of variables (default a quarter of the clauses)\n"
+"     --sizes <size>:<weight>[,<size>:<weight>...]\n"
+"                   mix of clause sizes (default '2:20,3:60,4:10,8:10')\n"
+"     --comments <permille>\n"
+"                   comment lines per thousand clauses (default '0')\n"
+"     --noise       add white-space noise and empty lines\n"
+"     --seed <seed> seed of the random number generator (default '0')\n"
+"     --compress <tool>\n"
+"                   compress both files with 'gzip', 'xz', 'bzip2' or 'zstd'\n"
+"\n"
+"Generates a random satisfiable formula in DIMACS format together with a\n"
+"satisfying model in SAT competition output format.  The output only\n"
+"depends on the options (and not on the machine), so the same benchmarks\n"
+"can be generated again to compare different builds of 'dimocheck'.  Each\n"
+"clause is satisfied by one literal of the model at a random position and\n"
+"its other literals are random.  Values of the model are printed twenty\n"
+"per 'v' line, thus checking needs relaxed parsing (the default).\n"
+"Compression is done through a pipe to the given tool.\n"
+;
+// clang-format on
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXIMUM_SIZES 64
+
+static struct {
+  unsigned size[MAXIMUM_SIZES], weight[MAXIMUM_SIZES];
+  unsigned count, total;
+} sizes;
+
+static uint64_t state;
+static unsigned comments;
+static bool noise;
+static const char *tool;
+
+static void die(const char *fmt, const char *arg) {
+  fputs("generate: error: ", stderr);
+  fprintf(stderr, fmt, arg);
+  fputc('\n', stderr);
+  exit(1);
+}
+
+// Random numbers by 'splitmix64', which is good enough and fast.
+
+static uint64_t next(void) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+static uint64_t pick(uint64_t n) { return (next() >> 11) % n; }
+
+static uint64_t parse_number(const char *option, const char *arg,
+                             bool suffix) {
+  uint64_t res = 0;
+  const char *p = arg;
+  if (!*p)
+    die("invalid argument '%s'", option);
+  for (; '0' <= *p && *p <= '9'; p++) {
+    if (res > (UINT64_MAX - 9) / 10)
+      die("argument of '%s' too large", option);
+    res = 10 * res + (*p - '0');
+  }
+  unsigned shift = 0;
+  if (suffix && *p == 'K')
+    shift = 10, p++;
+  else if (suffix && *p == 'M')
+    shift = 20, p++;
+  else if (suffix && *p == 'G')
+    shift = 30, p++;
+  if (*p || p == arg || res > UINT64_MAX >> shift)
+    die("invalid argument of '%s'", option);
+  return res << shift;
+}
+
+static void parse_sizes(const char *arg) {
+  sizes.count = sizes.total = 0;
+  for (const char *p = arg; *p;) {
+    char *end;
+    const unsigned long size = strtoul(p, &end, 10);
+    if (end == p || *end != ':' || !size || size > 1000)
+      die("invalid clause size mix '%s'", arg);
+    p = end + 1;
+    const unsigned long weight = strtoul(p, &end, 10);
+    if (end == p || (*end && *end != ',') || weight > 1000000)
+      die("invalid clause size mix '%s'", arg);
+    if (sizes.count == MAXIMUM_SIZES)
+      die("too many clause sizes in '%s'", arg);
+    sizes.size[sizes.count] = size;
+    sizes.weight[sizes.count++] = weight;
+    sizes.total += weight;
+    p = *end ? end + 1 : end;
+  }
+  if (!sizes.total)
+    die("clause size mix '%s' without weight", arg);
+}
+
+static unsigned clause_size(void) {
+  uint64_t w = pick(sizes.total);
+  unsigned i = 0;
+  while (w >= sizes.weight[i])
+    w -= sizes.weight[i++];
+  return sizes.size[i];
+}
+
+static double average_clause_size(void) {
+  double sum = 0;
+  for (unsigned i = 0; i != sizes.count; i++)
+    sum += (double)sizes.size[i] * sizes.weight[i];
+  return sum / sizes.total;
+}
+
+// Average number of digits of the numbers from one to 'n'.
+
+static double average_digits(uint64_t n) {
+  double sum = 0;
+  uint64_t low = 1;
+  for (unsigned digits = 1; low <= n; digits++, low *= 10) {
+    const uint64_t high = low * 10 - 1 < n ? low * 10 - 1 : n;
+    sum += (double)(high - low + 1) * digits;
+  }
+  return sum / n;
+}
+
+// Output is formatted by hand into a large buffer, since 'fprintf' would
+// dominate the time to generate large files.
+
+static char buffer[1 << 16];
+static size_t buffered;
+static uint64_t written;
+
+static void flush(FILE *file) {
+  if (fwrite(buffer, 1, buffered, file) != buffered)
+    die("%s", "writing failed");
+  written += buffered;
+  buffered = 0;
+}
+
+static void put(FILE *file, char ch) {
+  if (buffered == sizeof buffer)
+    flush(file);
+  buffer[buffered++] = ch;
+}
+
+static void puts_buffered(FILE *file, const char *str) {
+  while (*str)
+    put(file, *str++);
+}
+
+static void put_literal(FILE *file, int64_t lit) {
+  char chars[24], *p = chars + sizeof chars;
+  uint64_t u = lit < 0 ? -lit : lit;
+  do
+    *--p = '0' + u % 10;
+  while (u /= 10);
+  if (lit < 0)
+    *--p = '-';
+  while (p != chars + sizeof chars)
+    put(file, *p++);
+}
+
+static void put_space(FILE *file) {
+  if (noise && !pick(8)) {
+    const unsigned n = 1 + pick(3);
+    for (unsigned i = 0; i != n; i++)
+      put(file, pick(2) ? ' ' : '\t');
+  } else
+    put(file, ' ');
+}
+
+static FILE *open_output(const char *path) {
+  if (!tool)
+    return fopen(path, "w");
+  if (strchr(path, '\''))
+    die("can not compress to '%s' (quote in path)", path);
+  char *cmd = malloc(strlen(tool) + strlen(path) + 16);
+  if (!cmd)
+    die("%s", "out-of-memory");
+  sprintf(cmd, "%s -c > '%s'", tool, path);
+  FILE *file = popen(cmd, "w");
+  free(cmd);
+  return file;
+}
+
+static void close_output(FILE *file, const char *path) {
+  flush(file);
+  if (tool ? pclose(file) : fclose(file))
+    die("writing '%s' failed", path);
+}
+
+static bool value(const uint8_t *model, uint64_t idx) {
+  return model[idx / 8] >> (idx % 8) & 1;
+}
+
+int main(int argc, char **argv) {
+  const char *dimacs = 0, *solution = 0;
+  uint64_t size = 1u << 20, clauses = 0, variables = 0;
+  parse_sizes("2:20,3:60,4:10,8:10");
+  for (int i = 1; i != argc; i++) {
+    const char *arg = argv[i];
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+      fputs(usage, stdout);
+      return 0;
+    } else if (!strcmp(arg, "--noise"))
+      noise = true;
+    else if (arg[0] == '-' && arg[1]) {
+      if (i + 1 == argc)
+        die("argument to '%s' missing (try '-h')", arg);
+      const char *next_arg = argv[++i];
+      if (!strcmp(arg, "--size"))
+        size = parse_number(arg, next_arg, true);
+      else if (!strcmp(arg, "--clauses"))
+        clauses = parse_number(arg, next_arg, false);
+      else if (!strcmp(arg, "--variables"))
+        variables = parse_number(arg, next_arg, false);
+      else if (!strcmp(arg, "--sizes"))
+        parse_sizes(next_arg);
+      else if (!strcmp(arg, "--comments"))
+        comments = parse_number(arg, next_arg, false);
+      else if (!strcmp(arg, "--seed"))
+        state = parse_number(arg, next_arg, false);
+      else if (!strcmp(arg, "--compress"))
+        tool = next_arg;
+      else
+        die("invalid option '%s' (try '-h')", arg);
+    } else if (!dimacs)
+      dimacs = arg;
+    else if (!solution)
+      solution = arg;
+    else
+      die("%s", "too many files (try '-h')");
+  }
+  if (!solution)
+    die("%s", "DIMACS or solution file missing (try '-h')");
+  if (comments > 1000)
+    die("%s", "more than 1000 comment lines per 1000 clauses");
+
+  // Estimate the number of clauses from the size, where a literal needs
+  // its digits, a sign (for half of them) and a separator.
+  if (!clauses) {
+    const double literals = average_clause_size();
+    clauses = size / (literals * 3 + 2) + 1;
+    for (unsigned round = 0; round != 4; round++) {
+      const uint64_t v = variables ? variables : clauses / 4 + 1;
+      const double bytes = literals * (average_digits(v) + 1.5) + 2 +
+                           comments / 1000.0 * 42 +
+                           (noise ? literals / 8 + 1 / 64.0 : 0);
+      clauses = size / bytes + 1;
+    }
+  }
+  if (!variables)
+    variables = clauses / 4 + 1;
+  if (variables > INT32_MAX)
+    die("%s", "too many variables");
+
+  uint8_t *model = malloc(variables / 8 + 1);
+  if (!model)
+    die("%s", "out-of-memory allocating model");
+  for (uint64_t i = 0; i <= variables / 8; i++)
+    model[i] = next();
+
+  FILE *file = open_output(dimacs);
+  if (!file)
+    die("can not write '%s'", dimacs);
+  char header[64];
+  sprintf(header, "p cnf %" PRIu64 " %" PRIu64 "\n", variables, clauses);
+  puts_buffered(file, header);
+  for (uint64_t c = 0; c != clauses; c++) {
+    if (comments && pick(1000) < comments)
+      puts_buffered(file, "c comment line of the benchmark generator\n");
+    if (noise && !pick(64))
+      put(file, '\n');
+    const unsigned k = clause_size(), satisfied = pick(k);
+    for (unsigned i = 0; i != k; i++) {
+      const uint64_t idx = 1 + pick(variables);
+      bool sign = pick(2);
+      if (i == satisfied)
+        sign = value(model, idx);
+      put_literal(file, sign ? (int64_t)idx : -(int64_t)idx);
+      put_space(file);
+    }
+    puts_buffered(file, "0\n");
+  }
+  close_output(file, dimacs);
+  const uint64_t dimacs_bytes = written;
+
+  written = 0;
+  if (!(file = open_output(solution)))
+    die("can not write '%s'", solution);
+  puts_buffered(file, "c generated by 'bench/generate'\ns SATISFIABLE\n");
+  for (uint64_t idx = 1; idx <= variables; idx++) {
+    if (idx % 20 == 1)
+      puts_buffered(file, "v");
+    put(file, ' ');
+    put_literal(file, value(model, idx) ? (int64_t)idx : -(int64_t)idx);
+    if (!(idx % 20))
+      put(file, '\n');
+  }
+  puts_buffered(file, variables % 20 ? " 0\n" : "v 0\n");
+  close_output(file, solution);
+  free(model);
+
+  printf("generated '%s' with %" PRIu64 " variables and %" PRIu64
+         " clauses (%" PRIu64 " bytes%s)\n",
+         dimacs, variables, clauses, dimacs_bytes,
+         tool ? " uncompressed" : "");
+  return 0;
+}
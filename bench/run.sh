@@ -0,0 +1,84 @@
+#!/bin/sh
+# Generates benchmarks with 'bench/generate' and checks them with
+# 'dimocheck' writing one CSV line per benchmark into the report.
+usage () {
+cat <<END
+usage: bench/run.sh [ -h | --help ] [ <size> ... ]
+
+Generates for each size (default '1M 16M 128M', see 'bench/generate -h')
+a plain formula, one with comments and white-space noise and a 'gzip'
+compressed one (if 'gzip' is found) together with their models in
+'\$BENCH_DIR' (default 'bench/data').  Existing benchmarks are reused,
+since generating them is deterministic.  Then all models are checked by
+'dimocheck' (with the options in '\$BENCH_OPTIONS') one after the other
+and the report is written to '\$BENCH_REPORT' (default 'bench/report.csv')
+with parse time (of formula and model), check time, parse throughput,
+clauses per second and maximum resident set size for each benchmark.
+END
+}
+die () {
+  echo "bench/run.sh: error: $*" 1>&2
+  exit 1
+}
+msg () {
+  echo "[bench/run.sh] $*"
+}
+case "$1" in
+  -h|--help) usage; exit 0;;
+esac
+cd `dirname $0`/.. || exit 1
+binary=./dimocheck
+generate=./bench/generate
+[ -f $binary ] || die "could not find 'dimocheck' (run 'make' first)"
+[ -f $generate ] || die "could not find '$generate' (run 'make bench')"
+dir=${BENCH_DIR:-bench/data}
+report=${BENCH_REPORT:-bench/report.csv}
+sizes="$*"
+[ -n "$sizes" ] || sizes="1M 16M 128M"
+mkdir -p $dir || die "could not create '$dir'"
+manifest=$dir/manifest
+results=$dir/results.csv
+rm -f $manifest
+bench () {
+  name=$1
+  shift
+  cnf=$dir/$name.cnf$suffix
+  sol=$dir/$name.sol$suffix
+  if [ ! -f $dir/$name.info ]
+  then
+    msg "generating '$name'"
+    $generate "$@" $cnf $sol > $dir/$name.info || \
+      die "generating '$name' failed"
+  fi
+  echo "$cnf $sol" >> $manifest
+}
+for size in $sizes
+do
+  suffix=""
+  bench plain-$size --size $size
+  bench noise-$size --size $size --comments 50 --noise --seed 1
+  if type gzip 1>/dev/null 2>/dev/null
+  then
+    suffix=".gz"
+    bench gzip-$size --size $size --seed 2 --compress gzip
+  fi
+done
+msg "checking `wc -l < $manifest` benchmarks"
+$binary --manifest $manifest --results $results $BENCH_OPTIONS -q \
+  1>/dev/null || die "checking benchmarks failed"
+echo "benchmark,dimacs_bytes,clauses,parse_seconds,check_seconds,\
+parse_megabytes_per_second,clauses_per_second,maximum_resident_set_size" \
+  > $report
+tail -n +2 $results | tr -d '"' | while IFS=, read cnf sol status error \
+  parse check rss
+do
+  name=`basename $cnf | sed -e 's,\.cnf.*,,'`
+  set -- `sed -e 's,.* with \([0-9]*\) variables and \([0-9]*\) clauses (\([0-9]*\) bytes.*,\3 \2,' $dir/$name.info`
+  echo "$name $1 $2 $parse $check $rss" | awk '{
+    total = $4 + $5
+    printf "%s,%s,%s,%s,%s,%.1f,%.0f,%s\n", $1, $2, $3, $4, $5,
+      $4 ? $2 / $4 / 1048576 : 0, total ? $3 / total : 0, $6
+  }'
+done >> $report
+msg "wrote report '$report'"
+column -s, -t $report 2>/dev/null || cat $report
@@ -0,0 +1,59 @@
+#!/bin/sh
+# Compares the latency of checking a model by running 'dimocheck' for each
+# check with checking it through a server started with '--serve'.
+usage () {
+cat <<END
+usage: bench/serve.sh [ <dimacs> <solution> [ <checks> ] ]
+
+Checks '<solution>' against '<dimacs>' '<checks>' times (default '100')
+once by starting 'dimocheck' for each check and once with '--connect' to
+a server started with '--serve'.  The default formula and solution are
+'test/check/complete/good/prime2209.cnf' and '.sol'.
+END
+}
+die () {
+  echo "bench/serve.sh: error: $*" 1>&2
+  exit 1
+}
+case "$1" in
+  -h|--help) usage; exit 0;;
+esac
+cd `dirname $0`/.. || exit 1
+binary=./dimocheck
+[ -f $binary ] || die "could not find 'dimocheck' (run 'make' first)"
+cnf=${1:-test/check/complete/good/prime2209.cnf}
+sol=${2:-test/check/complete/good/prime2209.sol}
+checks=${3:-100}
+[ -f $cnf ] || die "could not find '$cnf'"
+[ -f $sol ] || die "could not find '$sol'"
+tmp=`mktemp -d` || die "could not create temporary directory"
+socket=$tmp/socket
+$binary --serve $socket -q 1>/dev/null 2>/dev/null &
+server=$!
+trap "kill $server 2>/dev/null; rm -rf $tmp" 0
+while [ ! -S $socket ]
+do
+  kill -0 $server 2>/dev/null || die "'dimocheck --serve $socket' failed"
+  sleep 0.1
+done
+now () {
+  date +%s%N
+}
+measure () {
+  start=`now`
+  i=0
+  while [ $i -lt $checks ]
+  do
+    "$@" 1>/dev/null || die "'$*' failed"
+    i=`expr $i + 1`
+  done
+  end=`now`
+  echo "$end $start $checks" | \
+  awk '{ printf "%.3f ms per check", ($1 - $2) / $3 / 1e6 }'
+}
+$binary --connect $socket $cnf $sol 1>/dev/null || \
+  die "first check through '$socket' failed"
+echo "[bench/serve.sh] checking '$sol' against '$cnf' $checks times"
+echo "[bench/serve.sh] fork per check: `measure $binary $cnf $sol -q`"
+echo "[bench/serve.sh] resident server: \
+`measure $binary --connect $socket $cnf $sol`"
@@ -0,0 +1,2 @@
+#define VERSION "0.0.1 c6e9f696355909ecd9934b621b021b232f0ef15c"
+#define COMPILE "gcc -Wall -pthread -O3 -DNDEBUG -DHAVE_ZLIB -DHAVE_LZMA -DHAVE_BZIP2"
@@ -1,6 +1,10 @@
+#ifndef LIBDIMOCHECK
 // clang-format off
 static const char * usage =
-"usage: dimocheck [ <option> ... ] <dimacs> <solution>\n"
+"usage: dimocheck [ <option> ... ] <dimacs> <solution> [ <solution> ... ]\n"
+"       dimocheck [ <option> ... ] --manifest <file>\n"
+"       dimocheck [ <option> ... ] --serve <socket>\n"
+"       dimocheck [ <option> ... ] --connect <socket> <dimacs> <solution>\n"
 "\n"
 "-h | --help        print this command line option summary\n"
 "-s | --strict      strict parsing (default is relaxed parsing)\n"
@@ -9,7 +13,37 @@ static const char * usage =
 "-v | --verbose     print verbose information\n"
 "-d | --debug       print debugging information\n"
 "-q | --quiet       no messages except the status line, warnings and errors\n"
+"-m | --model-first parse model first and check clauses while parsing DIMACS\n"
+"     --pipeline    read, tokenize and store/check clauses in three threads\n"
+"     --compact     store clauses compactly encoded (needs a regular file)\n"
+"     --scalar      check clauses without AVX2 gathers (for comparison)\n"
 "     --silent      really no message at all (exit code determines success)\n"
+"\n"
+"     --all-violations[=<limit>]\n"
+"                   report all (or the first '<limit>') violations\n"
+"     --follow[=<seconds>]\n"
+"                   read solution file while it is written (see below)\n"
+"     --decompress-threads <threads>\n"
+"                   number of decompression threads (default '1')\n"
+"     --parse-threads <threads>\n"
+"                   number of threads parsing DIMACS clauses (default '1')\n"
+"     --check-threads <threads>\n"
+"                   number of threads checking clauses (default '1')\n"
+"     --jobs <jobs>\n"
+"                   number of models checked concurrently (default '1')\n"
+"     --manifest <file>\n"
+"                   check pairs of DIMACS and solution files listed in file\n"
+"     --results <file>\n"
+"                   write results of '--manifest' checks as CSV to file\n"
+"     --serve <socket>\n"
+"                   keep formulas resident and check models on request\n"
+"     --serve-memory <megabytes>\n"
+"                   budget for resident formulas (default unlimited)\n"
+"     --connect <socket>\n"
+"                   request checking from a server started with '--serve'\n"
+"     --cache <directory>\n"
+"                   keep parsed formulas as binary images in '<directory>'\n"
+"\n"
 "     --banner      only print banner\n"
 "     --version     only print version\n"
 "\n"
@@ -18,10 +52,23 @@ static const char * usage =
 "with comment lines 'c', the status line 's', i.e., 's SATISFIABLE' and\n"
 "potentially several 'v' value lines.\n"
 "\n"
-"If the files are compressed, i.e., their file name has a '.gz', '.xz',\n"
-"'.bz2' file name suffix, then the tools tries to open them through a pipe\n"
-"and relies on the existence of external tools 'gzip', 'xz', or 'bzip2' to\n"
-"perform the actual decompression.\n"
+"The solution is read from '<stdin>' if '<solution>' is '-' and can also be\n"
+"a pipe (or socket) given as '/dev/fd/<n>'.  Since the DIMACS file is\n"
+"parsed first, the model is checked while the solver is still writing it.\n"
+"With '--follow' a regular solution file is read while it is written (and\n"
+"even before it exists) until the line with the terminating zero of the\n"
+"model is complete.  The optional limit gives the number of seconds\n"
+"without new input after which reading the solution fails.\n"
+"\n"
+"Compressed files are recognized by their magic bytes (not their suffix).\n"
+"Supported are 'gzip', 'xz', 'bzip2' and 'zstd' compressed files, which are\n"
+"decompressed in-process if the corresponding library was available at\n"
+"compile time.  Otherwise the tool falls back to open them through a pipe\n"
+"and relies on the existence of external tools 'gzip', 'xz', 'bzip2', or\n"
+"'zstd' to perform the actual decompression.  With more than one\n"
+"decompression thread, multi-member gzip files written by 'bgzip',\n"
+"multi-frame (and seekable) zstd files and multi-block xz files are\n"
+"decompressed block-parallel.\n"
 "\n"
 "If checking succeeds the program returns with exit code '0' and prints the\n"
 "line 's MODEL_SATISFIES_FORMULA' on '<stdout>'.  Errors are reported on\n"
@@ -36,65 +83,297 @@ static const char * usage =
 "satisfy each clause (a literal without value is treated as false in each\n"
 "clause).  Strict and complete parsing and checking can be enforced with\n"
 "'--strict', '--complete', or '--pedantic'.\n"
+"\n"
+"In model-first mode the model is parsed after the DIMACS header and the\n"
+"clauses are checked while they are parsed without being stored.  This\n"
+"needs memory only for the model, but the DIMACS file has to be opened\n"
+"twice (thus can not be a pipe).  Checking that model values do not exceed\n"
+"the maximum DIMACS variable and completeness checking are done at the end.\n"
+"\n"
+"With '--pipeline' reading (and decompressing) the clause section of the\n"
+"DIMACS file, tokenizing it and storing (or in model-first mode checking)\n"
+"the clauses are overlapped in three threads.  With '--verbose' the time\n"
+"each stage stalled waiting for its neighbors is reported.\n"
+"\n"
+"With '--compact' clauses are stored with sorted literals as variable length\n"
+"encoded differences of variable indices, which usually needs much less\n"
+"memory at the price of decoding clauses while checking.  The original order\n"
+"of literals of an unsatisfied clause is recovered by parsing it again.\n"
+"\n"
+"With '--check-threads' the stored clauses are checked in blocks by several\n"
+"threads.  The reported unsatisfied clause is still the first in the file.\n"
+"\n"
+"With '--all-violations' checking does not stop at the first unsatisfied\n"
+"clause (or missing value in complete mode).  All violations are counted\n"
+"but only the first '<limit>' unsatisfied clauses and missing values are\n"
+"printed, followed by a summary with the number of unsatisfied clauses by\n"
+"clause size.  Clauses are then checked by a single thread.\n"
+"\n"
+"With '--cache' the parsed formula is saved in the given directory as a\n"
+"binary image, which is memory mapped instead of parsing the DIMACS file\n"
+"again in later runs (with the same parsing mode) as long as size,\n"
+"modification time and content of the DIMACS file are unchanged.  Warnings\n"
+"of the original parse are printed again.  This needs a regular file and\n"
+"can not be combined with '--model-first'.\n"
+"\n"
+"With several '<solution>' files the formula is parsed only once and all\n"
+"models are checked against it in separate processes, up to '--jobs' at\n"
+"the same time.  Their messages and errors are printed in the order of the\n"
+"solution files, each followed by the line 's MODEL_SATISFIES_FORMULA' or\n"
+"'s MODEL_CHECK_FAILED' with the path of the solution file.  The exit code\n"
+"is only zero if all models satisfy the formula.\n"
+"\n"
+"With '--manifest' no files are given on the command line.  Instead each\n"
+"line of the manifest file lists a DIMACS file and a solution file, except\n"
+"for empty lines and lines starting with '#'.  These pairs are checked in\n"
+"separate processes (up to '--jobs' at the same time), starting with the\n"
+"largest pair of files.  Output and status lines are printed as in batch\n"
+"mode.  With '--results' each check is written as one CSV line with the\n"
+"status, the first error line, parse and check times in seconds and the\n"
+"maximum resident set size in bytes of the checking process.\n"
+"\n"
+"With '--serve' the program listens on a Unix domain socket for requests to\n"
+"check a model against a formula.  Each formula is parsed once by a formula\n"
+"process and kept resident, and each request is checked by a forked process\n"
+"which shares the parsed clauses with its formula process.  Options such as\n"
+"'--strict', '--complete' or '--quiet' given to the server apply to all\n"
+"checks.  If the resident set size of all formula processes exceeds the\n"
+"budget of '--serve-memory' the least recently used formulas are evicted.\n"
+"A request consists of a line with the path of the DIMACS file and a line\n"
+"with the path of the solution file, or '-' followed by the solution itself.\n"
+"The response is the output of parsing and checking (messages and errors\n"
+"merged) ending with 's MODEL_SATISFIES_FORMULA' or 's MODEL_CHECK_FAILED'.\n"
+"With '--connect' such a request is sent to the server (where '<solution>'\n"
+"can be '-' to send the standard input) and the exit code is only zero if\n"
+"the model satisfies the formula.\n"
 ;
 // clang-format on
+#endif
 
 #include "config.h"
+#include "dimocheck.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
+#include <sched.h>
+#include <setjmp.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #define PREFIX "[dimocheck] "
 
-static int verbosity;
-static bool complete;
-static bool strict;
+// Mutable global state is declared with 'STATE'.  The library keeps it per
+// thread, such that different contexts can be used concurrently in different
+// threads, while in the command line tool it is shared with worker threads.
 
-static const char *strict_option;
-static const char *complete_option;
+#ifdef LIBDIMOCHECK
+#define STATE static __thread
+#else
+#define STATE static
+#endif
 
-struct clause {
-  size_t lineno;
-  size_t column;
-  size_t size;
-  int literals[];
+STATE int verbosity;
+STATE bool complete;
+STATE bool strict;
+STATE bool model_first;
+STATE bool pipelined;
+STATE unsigned decompress_threads = 1;
+STATE unsigned parse_threads = 1;
+STATE unsigned check_threads = 1;
+
+STATE const char *strict_option;
+STATE const char *complete_option;
+
+struct position {
+  size_t lineno, column;
 };
 
-static const char *dimacs_path;
-static const char *model_path;
+STATE const char *dimacs_path;
+STATE const char *model_path;
 
-static FILE *file;
-static int close_file;
-static size_t lineno;
-static size_t column;
-static size_t charno;
-static const char *path;
-static int last_char[2];
+STATE FILE *file;
+STATE int close_file;
+STATE int fd;
+STATE const char *path;
 
-static int maximum_dimacs_variable;
-static int maximum_model_variable;
-static size_t parsed_clauses;
+STATE int maximum_dimacs_variable;
+STATE int maximum_model_variable;
+STATE size_t parsed_clauses;
 
-static struct {
+STATE size_t specified_variables;
+STATE size_t specified_clauses;
+
+STATE struct {
   int *begin, *end, *allocated;
 } literals;
 
-static struct {
-  struct clause **begin, **end, **allocated;
-} clauses;
+// Clauses are stored by size.  Unit, binary and ternary clauses are kept
+// without any header in 'units', 'binaries' and 'ternaries' respectively.
+// All other clauses follow each other in the 'arena', where the literals
+// of the general clause with index 'i' (starting at zero) range from
+// 'offsets.begin[i]' up to (but excluding) 'offsets.begin[i + 1]'.  The
+// 'kinds' array keeps the size of each clause in file order with two bits
+// per clause (zero for general clauses) in order to map clauses back to
+// their index in the file (see 'clause_index').
 
-static struct {
-  int *begin;
+#define MINIMUM_STORE_SIZE (1u << 20)
+#define MAXIMUM_RESERVED_CLAUSES (1u << 24)
+
+struct store {
+  int *begin, *end, *allocated;
+};
+
+STATE struct store units, binaries, ternaries, arena;
+
+STATE struct {
+  size_t *begin, *end, *allocated;
+} offsets;
+
+STATE struct {
+  unsigned char *begin;
+  size_t size, capacity;
+} kinds;
+
+// With '--compact' all clauses are instead encoded into the byte stream
+// 'compacted', each as its number of literals followed by its literals
+// sorted by variable index.  A literal is encoded as the difference of its
+// variable to the previous variable shifted left by one plus its sign bit.
+// All these numbers are written as variable length integers with seven
+// bits per byte.  The original order of literals is only needed to report
+// an unsatisfied clause, which is then parsed again from the DIMACS file.
+
+STATE bool compact;
+
+STATE struct {
+  unsigned char *begin, *end, *allocated;
+  size_t clauses;
+} compacted;
+
+// The byte offset of every compacted clause with an index which is a
+// multiple of 'CHECK_BLOCK_SIZE' in order to check blocks concurrently.
+
+#define CHECK_BLOCK_SIZE (1u << 14)
+
+STATE struct {
+  size_t *begin, *end, *allocated;
+} checkpoints;
+
+STATE struct {
+  unsigned *begin;
+  size_t capacity;
+} keys;
+
+// Clause positions are only stored if the DIMACS file can not be read
+// again (see 'locate_unsatisfied_clause').
+
+STATE bool clause_positions;
+STATE size_t locating;
+
+STATE struct {
+  struct position *begin, *end, *allocated;
+} positions;
+
+// The model is a literal indexed bit table with two bits per variable.  The
+// bit of a literal is set if the literal is assigned to true, where '-idx'
+// is mapped to bit '2 * idx' and 'idx' to bit '2 * idx + 1' (without 'abs'
+// nor branching on the sign, see 'literal_bit').  Variables from zero up to
+// (but excluding) 'size' are covered and 'capacity' is a multiple of 32.
+
+STATE struct {
+  uint64_t *begin;
   size_t size, capacity;
 } values;
 
+// Values of variables not covered by 'values' are kept in the hash table
+// 'sparse' (open addressing with linear probing), which maps a variable to
+// its assigned literal (zero marks empty slots).  Thus a single value with
+// a huge variable index in a solution does not need a huge value table.
+
+STATE struct {
+  int *table;
+  size_t count, capacity;
+} sparse;
+
+// Input is read through this buffer.  For regular uncompressed files it
+// is a window into the memory mapped file, which is moved forward on each
+// refill while pages behind the cursor are released.  Otherwise the
+// buffer is allocated and filled by 'read' from the file descriptor or by
+// an in-process decompressor (see 'decompress' below).
+
+#define STREAM_BUFFER_SIZE (1u << 20)
+#define MAPPED_WINDOW_SIZE (1u << 24)
+
+STATE struct {
+  unsigned char *begin, *pos, *end;
+} buffer;
+
+STATE struct {
+  unsigned char *begin, *end;
+} mapped;
+
+// Library calls can parse a buffer in memory, which is then used as if it
+// was a memory mapped file (but is neither released nor unmapped).
+
+STATE struct {
+  const unsigned char *begin, *end;
+  const char *name;
+} memory;
+
+STATE bool mapped_memory;
+
+STATE unsigned char *stream_buffer;
+
+// Only the buffer cursor is moved while reading characters.  Positions are
+// given as the number of characters read ('charno'), i.e., the position of
+// a character starting at one.  Lines are counted lazily when a line or
+// column number is needed (see 'count_lines_to'), which happens for
+// diagnostics and clause positions, always at increasing positions.  The
+// 'counted' characters contain 'lines' new-lines and the last counted line
+// respectively the one before it start at offset 'line' and 'previous'.
+
+STATE size_t buffer_offset;
+STATE bool end_of_file;
+
+STATE struct {
+  size_t offset, lines, line, previous;
+} counted;
+
 static void msg(const char *, ...) __attribute__((format(printf, 1, 2)));
 static void vrb(const char *, ...) __attribute__((format(printf, 1, 2)));
 
@@ -112,6 +391,11 @@ static void wrr(size_t, const char *, ...)
 
 static void wrn(const char *, ...) __attribute__((format(printf, 1, 2)));
 
+static void synchronize_pipeline(void);
+static void locate_unsatisfied_clause(size_t);
+static size_t column_of(size_t);
+static size_t current_line(void);
+
 static void msg(const char *fmt, ...) {
   if (verbosity < 0)
     return;
@@ -136,83 +420,140 @@ static void vrb(const char *fmt, ...) {
   fflush(stdout);
 }
 
+// Errors are written to 'errors', which is '<stderr>' for the command line
+// tool.  For library calls (see 'dimocheck.h') errors are written to a
+// memory stream instead and 'failed' returns to the library function.
+
+STATE FILE *errors;
+
+STATE struct {
+  bool active;
+  jmp_buf failed;
+  int status;
+  size_t clause, lineno, column;
+} library;
+
+static void failed(int) __attribute__((noreturn));
+
+static void failed(int status) {
+  if (library.active) {
+    if (library.status == DIMOCHECK_SATISFIED)
+      library.status = status;
+    longjmp(library.failed, 1);
+  }
+  exit(1);
+}
+
 static void die(const char *fmt, ...) {
   if (verbosity != INT_MIN) {
-    fputs("dimocheck: error: ", stderr);
+    fputs("dimocheck: error: ", errors);
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(stderr, fmt, ap);
+    vfprintf(errors, fmt, ap);
     va_end(ap);
-    fputc('\n', stderr);
+    fputc('\n', errors);
   }
-  exit(1);
+  failed(DIMOCHECK_ERROR);
 }
 
 static void fatal(const char *fmt, ...) {
   if (verbosity != INT_MIN) {
-    fputs("dimocheck: fatal error: ", stderr);
+    fputs("dimocheck: fatal error: ", errors);
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(stderr, fmt, ap);
+    vfprintf(errors, fmt, ap);
     va_end(ap);
-    fputc('\n', stderr);
+    fputc('\n', errors);
   }
+  if (library.active)
+    failed(DIMOCHECK_FATAL);
   abort();
   exit(1); // Unreachable but kept for safety.
 }
 
 static void err(size_t token, const char *fmt, ...) {
-  assert(last_char[0] != '\n' || lineno > 1);
+  synchronize_pipeline();
+  library.column = column_of(token);
+  library.lineno = current_line();
   if (verbosity != INT_MIN) {
-    fprintf(stderr, "%s:%zu:%zu: parse error: ", path,
-            lineno - (last_char[0] == '\n'), token);
+    fprintf(errors, "%s:%zu:%zu: parse error: ", path, library.lineno,
+            library.column);
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(stderr, fmt, ap);
+    vfprintf(errors, fmt, ap);
     va_end(ap);
-    fputc('\n', stderr);
+    fputc('\n', errors);
   }
-  exit(1);
+  failed(DIMOCHECK_PARSE_ERROR);
 }
 
 static void srr(size_t token, const char *fmt, ...) {
-  assert(last_char[0] != '\n' || lineno > 1);
+  synchronize_pipeline();
+  library.column = column_of(token);
+  library.lineno = current_line();
   if (verbosity != INT_MIN) {
-    fprintf(stderr, "%s:%zu:%zu: strict parsing error: ", path,
-            lineno - (last_char[0] == '\n'), token);
+    fprintf(errors, "%s:%zu:%zu: strict parsing error: ", path,
+            library.lineno, library.column);
     va_list ap;
     va_start(ap, fmt);
-    vfprintf(stderr, fmt, ap);
+    vfprintf(errors, fmt, ap);
     va_end(ap);
-    fputc('\n', stderr);
+    fputc('\n', errors);
   }
-  exit(1);
+  failed(DIMOCHECK_PARSE_ERROR);
 }
 
+// Warnings while parsing the DIMACS file are also recorded (without the
+// path) for the formula cache, even if they are not printed.
+
+STATE FILE *recorded_warnings;
+
 static void wrr(size_t token, const char *fmt, ...) {
-  assert(last_char[0] != '\n' || lineno > 1);
-  if (verbosity < 0)
+  synchronize_pipeline();
+  if (verbosity < 0 && !recorded_warnings)
     return;
-  fprintf(stderr, "%s:%zu:%zu: warning: ", path,
-          lineno - (last_char[0] == '\n'), token);
+  const size_t column = column_of(token);
+  const size_t lineno = current_line();
   va_list ap;
   va_start(ap, fmt);
-  vfprintf(stderr, fmt, ap);
+  if (recorded_warnings) {
+    va_list copy;
+    va_copy(copy, ap);
+    fprintf(recorded_warnings, ":%zu:%zu: warning: ", lineno, column);
+    vfprintf(recorded_warnings, fmt, copy);
+    fputc('\n', recorded_warnings);
+    va_end(copy);
+  }
+  if (verbosity >= 0) {
+    fprintf(errors, "%s:%zu:%zu: warning: ", path, lineno, column);
+    vfprintf(errors, fmt, ap);
+    fputc('\n', errors);
+    fflush(errors);
+  }
   va_end(ap);
-  fputc('\n', stderr);
-  fflush(stderr);
 }
 
 static void wrn(const char *fmt, ...) {
-  if (verbosity < 0)
+  synchronize_pipeline();
+  if (verbosity < 0 && !recorded_warnings)
     return;
-  fprintf(stderr, "%s: warning: ", path);
   va_list ap;
   va_start(ap, fmt);
-  vfprintf(stderr, fmt, ap);
+  if (recorded_warnings) {
+    va_list copy;
+    va_copy(copy, ap);
+    fputs(": warning: ", recorded_warnings);
+    vfprintf(recorded_warnings, fmt, copy);
+    fputc('\n', recorded_warnings);
+    va_end(copy);
+  }
+  if (verbosity >= 0) {
+    fprintf(errors, "%s: warning: ", path);
+    vfprintf(errors, fmt, ap);
+    fputc('\n', errors);
+    fflush(errors);
+  }
   va_end(ap);
-  fputc('\n', stderr);
-  fflush(stderr);
 }
 
 static bool full_literals(void) { return literals.end == literals.allocated; }
@@ -226,10 +567,11 @@ static size_t capacity_literals(void) {
 static void enlarge_literals(void) {
   const size_t old_capacity = capacity_literals();
   const size_t new_capacity = old_capacity ? 2 * old_capacity : 1;
-  literals.begin =
+  void *new_begin =
       realloc(literals.begin, new_capacity * sizeof *literals.begin);
-  if (!literals.begin)
+  if (!new_begin)
     fatal("out-of-memory reallocating stack of literals");
+  literals.begin = new_begin;
   literals.end = literals.begin + old_capacity;
   literals.allocated = literals.begin + new_capacity;
   vrb("enlarged literal stack to %zu", new_capacity);
@@ -244,44 +586,242 @@ static void push_literal(int lit) {
 
 static void clear_literals(void) { literals.end = literals.begin; }
 
-static bool full_clauses(void) { return clauses.end == clauses.allocated; }
+static size_t size_store(const struct store *store) {
+  return store->end - store->begin;
+}
+
+static const char *store_name(const struct store *store) {
+  return store == &units       ? "unit"
+         : store == &binaries  ? "binary"
+         : store == &ternaries ? "ternary"
+                               : "general";
+}
+
+static void enlarge_store(struct store *store, size_t size) {
+  const size_t old_size = size_store(store);
+  size_t new_capacity = 2 * (store->allocated - store->begin);
+  if (new_capacity < MINIMUM_STORE_SIZE)
+    new_capacity = MINIMUM_STORE_SIZE;
+  while (new_capacity - old_size < size)
+    new_capacity *= 2;
+  void *new_begin = realloc(store->begin, new_capacity * sizeof *store->begin);
+  if (!new_begin)
+    fatal("out-of-memory reallocating clause store");
+  store->begin = new_begin;
+  store->end = store->begin + old_size;
+  store->allocated = store->begin + new_capacity;
+  vrb("enlarged %s clause store to %zu literals", store_name(store),
+      new_capacity);
+}
+
+static void push_store(struct store *store, const int *begin,
+                       const int *end) {
+  const size_t size = end - begin;
+  if ((size_t)(store->allocated - store->end) < size)
+    enlarge_store(store, size);
+  if (size)
+    memcpy(store->end, begin, size * sizeof *begin);
+  store->end += size;
+}
+
+static void enlarge_offsets(void) {
+  const size_t size = offsets.end - offsets.begin;
+  size_t new_capacity = 2 * (offsets.allocated - offsets.begin);
+  if (new_capacity < MINIMUM_STORE_SIZE)
+    new_capacity = MINIMUM_STORE_SIZE;
+  void *new_begin =
+      realloc(offsets.begin, new_capacity * sizeof *offsets.begin);
+  if (!new_begin)
+    fatal("out-of-memory reallocating clause offsets");
+  offsets.begin = new_begin;
+  offsets.end = offsets.begin + size;
+  offsets.allocated = offsets.begin + new_capacity;
+  vrb("enlarged clause offsets to %zu", new_capacity);
+}
+
+static void push_offset(void) {
+  if (offsets.end == offsets.allocated)
+    enlarge_offsets();
+  *offsets.end++ = size_store(&arena);
+}
+
+static void reserve_kinds(size_t new_capacity) {
+  void *new_begin = realloc(kinds.begin, new_capacity);
+  if (!new_begin)
+    fatal("out-of-memory reallocating clause kinds");
+  kinds.begin = new_begin;
+  memset(kinds.begin + kinds.capacity, 0, new_capacity - kinds.capacity);
+  kinds.capacity = new_capacity;
+  vrb("reserved clause kinds for %zu clauses", 4 * new_capacity);
+}
+
+static void push_kind(unsigned kind) {
+  const size_t size = kinds.size;
+  if (size / 4 == kinds.capacity)
+    reserve_kinds(kinds.capacity ? 2 * kinds.capacity : MINIMUM_STORE_SIZE);
+  kinds.begin[size / 4] |= kind << (2 * (size % 4));
+  kinds.size = size + 1;
+}
+
+static unsigned kind_of(size_t i) {
+  return (kinds.begin[i / 4] >> (2 * (i % 4))) & 3;
+}
+
+static bool full_positions(void) {
+  return positions.end == positions.allocated;
+}
 
-static size_t capacity_clauses(void) {
-  return clauses.allocated - clauses.begin;
+static size_t capacity_positions(void) {
+  return positions.allocated - positions.begin;
 }
 
-static void enlarge_clauses(void) {
-  const size_t old_capacity = capacity_clauses();
+static void enlarge_positions(void) {
+  const size_t old_capacity = capacity_positions();
   const size_t new_capacity = old_capacity ? 2 * old_capacity : 1;
-  clauses.begin = realloc(clauses.begin, new_capacity * sizeof *clauses.begin);
-  if (!clauses.begin)
-    fatal("out-of-memory reallocating stack of clauses");
-  clauses.end = clauses.begin + old_capacity;
-  clauses.allocated = clauses.begin + new_capacity;
-  vrb("enlarged clauses stack to %zu", new_capacity);
+  void *new_begin =
+      realloc(positions.begin, new_capacity * sizeof *positions.begin);
+  if (!new_begin)
+    fatal("out-of-memory reallocating stack of positions");
+  positions.begin = new_begin;
+  positions.end = positions.begin + old_capacity;
+  positions.allocated = positions.begin + new_capacity;
+  vrb("enlarged positions stack to %zu", new_capacity);
+}
+
+static void enlarge_compacted(void) {
+  const size_t size = compacted.end - compacted.begin;
+  size_t new_capacity = 2 * (compacted.allocated - compacted.begin);
+  if (new_capacity < MINIMUM_STORE_SIZE)
+    new_capacity = MINIMUM_STORE_SIZE;
+  void *new_begin = realloc(compacted.begin, new_capacity);
+  if (!new_begin)
+    fatal("out-of-memory reallocating compacted clauses");
+  compacted.begin = new_begin;
+  compacted.end = compacted.begin + size;
+  compacted.allocated = compacted.begin + new_capacity;
+  vrb("enlarged compacted clauses to %zu bytes", new_capacity);
+}
+
+// Needs at most ten bytes for 64-bit and five bytes for 32-bit numbers.
+
+static void push_varint(size_t u) {
+  if (compacted.allocated - compacted.end < 10)
+    enlarge_compacted();
+  unsigned char *p = compacted.end;
+  while (u > 127) {
+    *p++ = (u & 127) | 128;
+    u >>= 7;
+  }
+  *p++ = u;
+  compacted.end = p;
+}
+
+static size_t decode_varint(const unsigned char **p) {
+  const unsigned char *q = *p;
+  size_t res = 0;
+  unsigned shift = 0, byte;
+  do {
+    byte = *q++;
+    res |= (size_t)(byte & 127) << shift;
+    shift += 7;
+  } while (byte & 128);
+  *p = q;
+  return res;
+}
+
+static void push_checkpoint(void) {
+  if (checkpoints.end == checkpoints.allocated) {
+    const size_t old_capacity = checkpoints.allocated - checkpoints.begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 64;
+    void *new_begin =
+        realloc(checkpoints.begin, new_capacity * sizeof *checkpoints.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating compacted check-points");
+    checkpoints.begin = new_begin;
+    checkpoints.end = checkpoints.begin + old_capacity;
+    checkpoints.allocated = checkpoints.begin + new_capacity;
+  }
+  *checkpoints.end++ = compacted.end - compacted.begin;
+}
+
+static int cmp_keys(const void *p, const void *q) {
+  const unsigned a = *(const unsigned *)p, b = *(const unsigned *)q;
+  return (a > b) - (a < b);
+}
+
+// The sort key of a literal is its variable shifted left by one plus its
+// sign bit.  Clauses are usually short and thus sorted by insertion.
+
+static void push_compacted(const int *begin, const int *end) {
+  const size_t size = end - begin;
+  if (size > keys.capacity) {
+    size_t new_capacity = keys.capacity ? 2 * keys.capacity : 16;
+    while (new_capacity < size)
+      new_capacity *= 2;
+    void *new_begin = realloc(keys.begin, new_capacity * sizeof *keys.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating sort keys");
+    keys.begin = new_begin;
+    keys.capacity = new_capacity;
+  }
+  unsigned *k = keys.begin;
+  for (size_t i = 0; i != size; i++) {
+    const int lit = begin[i];
+    unsigned key = 2u * (unsigned)abs(lit) + (lit < 0);
+    size_t j = i;
+    if (size <= 32)
+      while (j && k[j - 1] > key)
+        k[j] = k[j - 1], j--;
+    k[j] = key;
+  }
+  if (size > 32)
+    qsort(k, size, sizeof *k, cmp_keys);
+  if (!(compacted.clauses++ % CHECK_BLOCK_SIZE))
+    push_checkpoint();
+  push_varint(size);
+  unsigned previous = 0;
+  for (size_t i = 0; i != size; i++) {
+    const unsigned variable = k[i] >> 1;
+    push_varint(2u * (variable - previous) + (k[i] & 1));
+    previous = variable;
+  }
 }
 
-static size_t bytes_clause(size_t size) {
-  return sizeof(struct clause) + size * sizeof(int);
+// Add the clause with the literals in '[begin, end)' to the clause store.
+
+static void add_clause(const int *begin, const int *end) {
+  if (compact) {
+    push_compacted(begin, end);
+    return;
+  }
+  const size_t size = end - begin;
+  unsigned kind = 0;
+  if (size == 1)
+    push_store(&units, begin, end), kind = 1;
+  else if (size == 2)
+    push_store(&binaries, begin, end), kind = 2;
+  else if (size == 3)
+    push_store(&ternaries, begin, end), kind = 3;
+  else {
+    push_store(&arena, begin, end);
+    push_offset();
+  }
+  push_kind(kind);
 }
 
 static void push_clause(size_t lineno, size_t column) {
-  size_t size = size_literals();
-  size_t bytes = bytes_clause(size);
-  struct clause *clause = malloc(bytes);
-  if (!clause)
-    fatal("out-of-memory allocating clause");
-  clause->size = size;
-  clause->lineno = lineno;
-  clause->column = column;
-  size_t bytes_literals = size * sizeof(int);
-  memcpy(clause->literals, literals.begin, bytes_literals);
-  if (full_clauses())
-    enlarge_clauses();
-  *clauses.end++ = clause;
+  const size_t size = size_literals();
+  add_clause(literals.begin, literals.end);
+  if (clause_positions) {
+    if (full_positions())
+      enlarge_positions();
+    positions.end->lineno = lineno;
+    positions.end->column = column;
+    positions.end++;
+  }
   if (verbosity == INT_MAX) {
     printf(PREFIX "new size %zu clause[%zu]", size, parsed_clauses);
-    const int *p = clause->literals, *end = p + size;
+    const int *p = literals.begin, *end = literals.end;
     while (p != end)
       printf(" %d", *p++);
     fputc('\n', stdout);
@@ -289,24 +829,117 @@ static void push_clause(size_t lineno, size_t column) {
   }
 }
 
+static unsigned literal_bit(int lit) {
+  return ((2u * (unsigned)lit) ^ (unsigned)(lit >> 31)) + 1;
+}
+
+static size_t sparse_slot(size_t idx) {
+  return ((uint64_t)idx * 0x9e3779b97f4a7c15) >> 32 & (sparse.capacity - 1);
+}
+
+static int sparse_value(size_t idx) {
+  if (!sparse.count)
+    return 0;
+  const size_t mask = sparse.capacity - 1;
+  for (size_t i = sparse_slot(idx);; i = (i + 1) & mask) {
+    const int lit = sparse.table[i];
+    if (!lit || (size_t)abs(lit) == idx)
+      return lit;
+  }
+}
+
+static void insert_sparse(int lit) {
+  const size_t idx = abs(lit), mask = sparse.capacity - 1;
+  size_t i = sparse_slot(idx);
+  while (sparse.table[i] && (size_t)abs(sparse.table[i]) != idx)
+    i = (i + 1) & mask;
+  sparse.count += !sparse.table[i];
+  sparse.table[i] = lit;
+}
+
+// Rehash all sparse values not covered by 'values' into a table with the
+// given capacity (a power of two) and move the others to 'values'.
+
+static void rehash_sparse(size_t new_capacity) {
+  int *old_table = sparse.table;
+  const size_t old_capacity = sparse.capacity;
+  int *new_table = calloc(new_capacity, sizeof *new_table);
+  if (!new_table)
+    fatal("out-of-memory allocating sparse values");
+  sparse.table = new_table;
+  sparse.capacity = new_capacity;
+  sparse.count = 0;
+  for (size_t i = 0; i != old_capacity; i++) {
+    const int lit = old_table[i];
+    if (!lit)
+      continue;
+    const unsigned bit = literal_bit(lit);
+    if (bit / 2 < values.size)
+      values.begin[bit / 64] |= (uint64_t)1 << (bit % 64);
+    else
+      insert_sparse(lit);
+  }
+  free(old_table);
+}
+
 static void fit_values(size_t idx) {
   assert(idx <= (size_t)INT_MAX);
   const size_t old_capacity = values.capacity;
   if (idx >= old_capacity) {
-    size_t new_capacity = old_capacity ? 2 * old_capacity : 1;
+    size_t new_capacity = old_capacity ? 2 * old_capacity : 32;
     while (idx >= new_capacity)
       new_capacity *= 2;
-    values.begin = realloc(values.begin, new_capacity * sizeof *values.begin);
-    if (!values.begin)
-      fatal("out-of-memory reallocating value array");
+    const size_t old_words = old_capacity / 32, new_words = new_capacity / 32;
+    void *new_begin = realloc(values.begin, new_words * sizeof *values.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating value table");
+    values.begin = new_begin;
+    memset(values.begin + old_words, 0,
+           (new_words - old_words) * sizeof *values.begin);
     values.capacity = new_capacity;
   }
-  while (idx >= values.size) {
-    assert(values.size < values.capacity);
-    values.begin[values.size++] = 0;
+  if (idx >= values.size) {
+    values.size = idx + 1;
+    if (sparse.count)
+      rehash_sparse(sparse.capacity);
+  }
+}
+
+// Variables without value are treated as false.
+
+static bool falsified(int lit) {
+  const unsigned bit = literal_bit(lit);
+  if (bit / 2 >= values.size)
+    return sparse_value(abs(lit)) != lit;
+  return !(values.begin[bit / 64] >> (bit % 64) & 1);
+}
+
+// Returns the assigned literal of the variable or zero if unassigned.
+
+static int value_of(size_t idx) {
+  if (idx >= values.size)
+    return sparse_value(idx);
+  const unsigned bits = values.begin[idx / 32] >> (2 * (idx % 32)) & 3;
+  return bits == 2 ? (int)idx : bits == 1 ? -(int)idx : 0;
+}
+
+// The variable has to be either unassigned or already assigned to 'lit'.
+
+static void assign(int lit) {
+  assert(lit);
+  const unsigned bit = literal_bit(lit);
+  if (bit / 2 < values.size)
+    values.begin[bit / 64] |= (uint64_t)1 << (bit % 64);
+  else {
+    if (2 * (sparse.count + 1) > sparse.capacity)
+      rehash_sparse(sparse.capacity ? 2 * sparse.capacity : 16);
+    insert_sparse(lit);
   }
 }
 
+static double average(double a, double b) { return b ? a / b : 0; }
+static double percent(double a, double b) { return average(100 * a, b); }
+
 static bool has_suffix(const char *p, const char *q) {
   size_t k = strlen(p), l = strlen(q);
   return k >= l && !strcmp(p + k - l, q);
@@ -323,773 +956,5106 @@ static FILE *read_zipped(const char *zipper, const char *p) {
   return file;
 }
 
-static void init_parsing(const char *p) {
-  close_file = 2;
-  if (has_suffix(p, ".bz2"))
-    file = read_zipped("bunzip2", p);
-  else if (has_suffix(p, ".gz"))
-    file = read_zipped("gzip", p);
-  else if (has_suffix(p, ".xz"))
-    file = read_zipped("xz", p);
-  else {
-    file = fopen(path = p, "r");
-    close_file = 1;
+// Compressed files are recognized by the magic bytes at their start.  If
+// the corresponding library was found by 'configure' they are decompressed
+// in-process directly into the input buffer.  Otherwise we fall back to
+// reading them through a pipe from an external decompression tool.
+
+enum format { PLAIN, GZIP, XZ, BZIP2, ZSTD };
+
+static const struct {
+  const char *name, *suffix, *tool, *magic;
+  size_t bytes;
+} formats[] = {
+    {"plain", 0, 0, 0, 0},
+    {"gzip", ".gz", "gzip", "\x1f\x8b", 2},
+    {"xz", ".xz", "xz", "\xfd\x37\x7a\x58\x5a\x00", 6},
+    {"bzip2", ".bz2", "bunzip2", "BZh", 3},
+    {"zstd", ".zst", "zstd", "\x28\xb5\x2f\xfd", 4},
+};
+
+#define MAXIMUM_MAGIC_BYTES 6
+#define NUMBER_OF_FORMATS (sizeof formats / sizeof *formats)
+
+STATE enum format format;
+STATE enum format decoder;
+STATE bool decoded_to_end;
+
+STATE struct {
+  const unsigned char *begin, *end;
+} compressed;
+
+STATE unsigned char *compressed_buffer;
+
+#ifdef HAVE_ZLIB
+STATE z_stream gzip_stream;
+#endif
+#ifdef HAVE_LZMA
+STATE lzma_stream xz_stream = LZMA_STREAM_INIT;
+#endif
+#ifdef HAVE_BZIP2
+STATE bz_stream bzip2_stream;
+#endif
+#ifdef HAVE_ZSTD
+STATE ZSTD_DStream *zstd_stream;
+#endif
+
+static bool in_process_decoder(enum format f) {
+  switch (f) {
+#ifdef HAVE_ZLIB
+  case GZIP:
+    return true;
+#endif
+#ifdef HAVE_LZMA
+  case XZ:
+    return true;
+#endif
+#ifdef HAVE_BZIP2
+  case BZIP2:
+    return true;
+#endif
+#ifdef HAVE_ZSTD
+  case ZSTD:
+    return true;
+#endif
+  default:
+    return false;
   }
-  if (!file)
-    die("can not open and read '%s'", path);
-  last_char[0] = last_char[1] = EOF;
-  lineno = 1;
-  column = 0;
-  charno = 0;
 }
 
-static void reset_parsing(void) {
-  vrb("closing '%s'", path);
-  if (close_file == 1)
-    fclose(file);
-  if (close_file == 2)
-    pclose(file);
+static enum format detect_format(const unsigned char *start, size_t bytes) {
+  for (size_t f = PLAIN + 1; f != NUMBER_OF_FORMATS; f++)
+    if (bytes >= formats[f].bytes &&
+        !memcmp(start, formats[f].magic, formats[f].bytes))
+      return f;
+  return PLAIN;
 }
 
-static int next_char(void) {
-  int res = getc(file);
-  if (res == '\n')
-    lineno++;
-  if (res != EOF) {
-    if (last_char[0] == '\n')
-      column = 1;
-    else
-      column++;
-    charno++;
+// The reader thread of the pipeline (see 'read_blocks' below) reads ahead
+// of the parser and thus can not report read and decompression errors
+// directly, since the parser might still find an earlier error.  Instead it
+// jumps back and hands over the error message to the parser.
+
+static __thread bool reading_ahead;
+STATE jmp_buf reading_failed;
+STATE char input_error[256];
+
+static void input_failed(const char *, ...)
+    __attribute__((format(printf, 1, 2)));
+
+static void input_failed(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(input_error, sizeof input_error, fmt, ap);
+  va_end(ap);
+  if (reading_ahead)
+    longjmp(reading_failed, 1);
+  die("%s", input_error);
+}
+
+// With '--follow' a regular solution file is read while it is still being
+// written (like 'tail -f').  While 'tailing' the end of the file is not
+// taken as end-of-file but more input is polled (with increasing delays up
+// to 64 milliseconds) until the terminating zero of the model was parsed.
+// The file does not even have to exist yet.  The optional limit is the
+// number of seconds without new input after which reading fails.
+
+STATE bool follow;
+STATE double follow_limit;
+STATE bool tailing;
+
+static double wall_clock_time(void);
+
+static bool wait_for_input(double *idle, unsigned *delay) {
+  const double now = wall_clock_time();
+  if (!*idle)
+    *idle = now;
+  else if (follow_limit && now - *idle > follow_limit)
+    return false;
+  const struct timespec sleeping = {.tv_nsec = *delay * 1000000l};
+  nanosleep(&sleeping, 0);
+  if (*delay < 64)
+    *delay *= 2;
+  return true;
+}
+
+static size_t read_input(unsigned char *start, size_t size) {
+  ssize_t bytes;
+  double idle = 0;
+  unsigned delay = 1;
+  for (;;) {
+    do
+      bytes = read(fd, start, size);
+    while (bytes < 0 && errno == EINTR);
+    if (bytes < 0)
+      input_failed("reading '%s' failed", path);
+    if (bytes || !tailing)
+      return bytes;
+    if (!wait_for_input(&idle, &delay))
+      input_failed("no new input in '%s' within %g seconds", path,
+                   follow_limit);
   }
-  last_char[1] = last_char[0];
-  last_char[0] = res;
-  return res;
 }
 
-static bool is_space(int ch) {
-  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+// Tell the kernel that the pages of the mapped file before 'pos' are not
+// needed anymore.  They stay in the page cache but are not part of our
+// resident set anymore.  Releasing is only done in large steps.
+
+static void release_mapped(const unsigned char *pos) {
+  STATE const unsigned char *released;
+  if (mapped_memory)
+    return;
+  if (released < mapped.begin || released > mapped.end)
+    released = mapped.begin;
+  if ((size_t)(pos - released) < MAPPED_WINDOW_SIZE)
+    return;
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  unsigned char *start = mapped.begin;
+  start += (released - mapped.begin) / page_size * page_size;
+  unsigned char *end = mapped.begin;
+  end += (pos - mapped.begin) / page_size * page_size;
+  if (start < end)
+    (void)madvise(start, end - start, MADV_DONTNEED);
+  released = end;
 }
 
-static bool is_digit(int ch) { return '0' <= ch && ch <= '9'; }
+static bool refill_compressed(void) {
+  if (mapped.begin) {
+    release_mapped(compressed.begin);
+    return false;
+  }
+  size_t bytes = read_input(compressed_buffer, STREAM_BUFFER_SIZE);
+  compressed.begin = compressed_buffer;
+  compressed.end = compressed_buffer + bytes;
+  return bytes;
+}
 
-static const char *space_name(int ch) {
-  assert(is_space(ch));
-  if (ch == ' ')
-    return "space ' '";
-  if (ch == '\t')
-    return "tab-character '\\t'";
-  if (ch == '\r')
-    return "carriage-return '\\r'";
-  assert(ch == '\n');
-  return "new-line '\\n'";
+static void decoding_failed(const char *reason) {
+  input_failed("decompressing %s compressed '%s' failed (%s)",
+               formats[decoder].name, path, reason);
 }
 
-static void parse_dimacs(void) {
-  init_parsing(dimacs_path);
-  msg("parsing DIMACS '%s'", path);
-  if (strict) {
-    assert(strict_option);
-    msg("parsing in strict mode (due to '%s')", strict_option);
-  } else
-    msg("parsing in relaxed mode (without '--strict' nor '--pedantic')");
-  for (;;) {
-    int ch = next_char();
-    if (ch == EOF) {
-      if (charno)
-        err(column, "end-of-file before header (truncated file)");
-      else
-        err(column, "end-of-file before header (empty file)");
-    } else if (is_space(ch)) {
-      if (strict)
-        srr(column, "expected 'c' or 'p' at start of line");
-    } else if (ch == 'c') {
-      while ((ch = next_char()) != '\n')
-        if (ch == EOF)
-          err(column, "end-of-file in header comment");
-      continue;
-    } else if (ch == 'p')
+static void init_decoder(void) {
+  decoded_to_end = false;
+  switch (decoder) {
+#ifdef HAVE_ZLIB
+  case GZIP:
+    memset(&gzip_stream, 0, sizeof gzip_stream);
+    if (inflateInit2(&gzip_stream, 15 + 16) != Z_OK)
+      fatal("could not initialize 'zlib' decompressor");
+    break;
+#endif
+#ifdef HAVE_LZMA
+  case XZ:
+#if LZMA_VERSION >= 50040002
+    if (decompress_threads > 1) {
+      lzma_mt mt;
+      memset(&mt, 0, sizeof mt);
+      mt.flags = LZMA_CONCATENATED;
+      mt.threads = decompress_threads;
+      mt.memlimit_threading = lzma_physmem() / 4;
+      mt.memlimit_stop = UINT64_MAX;
+      if (lzma_stream_decoder_mt(&xz_stream, &mt) != LZMA_OK)
+        fatal("could not initialize multi-threaded 'liblzma' decompressor");
+      vrb("decompressing '%s' with %u 'liblzma' threads", path,
+          decompress_threads);
       break;
-    else
-      err(column, "unexpected character (expected 'p' or 'c')");
+    }
+#endif
+    if (lzma_stream_decoder(&xz_stream, UINT64_MAX, LZMA_CONCATENATED) !=
+        LZMA_OK)
+      fatal("could not initialize 'liblzma' decompressor");
+    break;
+#endif
+#ifdef HAVE_BZIP2
+  case BZIP2:
+    memset(&bzip2_stream, 0, sizeof bzip2_stream);
+    if (BZ2_bzDecompressInit(&bzip2_stream, 0, 0) != BZ_OK)
+      fatal("could not initialize 'libbz2' decompressor");
+    break;
+#endif
+#ifdef HAVE_ZSTD
+  case ZSTD:
+    if (!(zstd_stream = ZSTD_createDStream()))
+      fatal("could not initialize 'libzstd' decompressor");
+    break;
+#endif
+  default:
+    assert(!in_process_decoder(decoder));
+    break;
   }
-  int ch = next_char();
-  if (strict) {
-    if (ch != ' ')
-      srr(column, "expected %s after 'p'", space_name(' '));
-    ch = next_char();
-  } else {
-    if (ch != ' ' && ch != '\t')
-      err(column, "expected %s or %s after 'p'", space_name(' '),
-          space_name('\t'));
-    do
-      ch = next_char();
-    while (ch == ' ' || ch == '\t');
+}
+
+static void reset_decoder(void) {
+  switch (decoder) {
+#ifdef HAVE_ZLIB
+  case GZIP:
+    inflateEnd(&gzip_stream);
+    break;
+#endif
+#ifdef HAVE_LZMA
+  case XZ:
+    lzma_end(&xz_stream);
+    break;
+#endif
+#ifdef HAVE_BZIP2
+  case BZIP2:
+    BZ2_bzDecompressEnd(&bzip2_stream);
+    break;
+#endif
+#ifdef HAVE_ZSTD
+  case ZSTD:
+    ZSTD_freeDStream(zstd_stream);
+    zstd_stream = 0;
+    break;
+#endif
+  default:
+    break;
   }
-  if (ch != 'c')
-    err(column, "expected 'c'");
-  ch = next_char();
-  if (ch != 'n')
-    err(column, "expected 'n' after 'c'");
-  ch = next_char();
-  if (ch != 'f')
-    err(column, "expected 'f' after 'cn'");
-  ch = next_char();
-  if (strict) {
-    if (ch != ' ')
-      srr(column, "expected %s after 'p cnf'", space_name(' '));
-    ch = next_char();
+  decoder = PLAIN;
+}
+
+// Decode as much as possible of the available compressed input into the
+// given output buffer starting at 'decoded' and return the new number of
+// decoded bytes.  If no input is available anymore the decoder is asked to
+// flush its remaining output and to finish.  All decoders handle
+// concatenated streams the same way as the external tools.
+
+static size_t decode_chunk(unsigned char *start, size_t size, size_t decoded) {
+  (void)start, (void)size; // Unused without 'zlib' and 'zstd'.
+  const size_t available = compressed.end - compressed.begin;
+  switch (decoder) {
+#ifdef HAVE_ZLIB
+  case GZIP: {
+    if (decoded_to_end && available) {
+      inflateReset(&gzip_stream);
+      decoded_to_end = false;
+    }
+    z_stream *z = &gzip_stream;
+    z->next_in = (unsigned char *)compressed.begin;
+    z->avail_in = available < UINT_MAX ? available : UINT_MAX;
+    z->next_out = start + decoded;
+    z->avail_out = size - decoded;
+    int res = inflate(z, Z_NO_FLUSH);
+    compressed.begin = z->next_in;
+    decoded = size - z->avail_out;
+    if (res == Z_STREAM_END)
+      decoded_to_end = true;
+    else if (res != Z_OK && res != Z_BUF_ERROR)
+      decoding_failed(z->msg ? z->msg : "invalid data");
+  } break;
+#endif
+#ifdef HAVE_LZMA
+  case XZ: {
+    lzma_stream *x = &xz_stream;
+    x->next_in = compressed.begin;
+    x->avail_in = available;
+    x->next_out = start + decoded;
+    x->avail_out = size - decoded;
+    lzma_ret res = lzma_code(x, available ? LZMA_RUN : LZMA_FINISH);
+    compressed.begin = x->next_in;
+    decoded = size - x->avail_out;
+    if (res == LZMA_STREAM_END)
+      decoded_to_end = true;
+    else if (res != LZMA_OK && res != LZMA_BUF_ERROR)
+      decoding_failed("invalid data");
+  } break;
+#endif
+#ifdef HAVE_BZIP2
+  case BZIP2: {
+    if (decoded_to_end && available) {
+      BZ2_bzDecompressEnd(&bzip2_stream);
+      init_decoder();
+    }
+    bz_stream *b = &bzip2_stream;
+    b->next_in = (char *)compressed.begin;
+    b->avail_in = available < UINT_MAX ? available : UINT_MAX;
+    b->next_out = (char *)start + decoded;
+    b->avail_out = size - decoded;
+    int res = BZ2_bzDecompress(b);
+    compressed.begin = (const unsigned char *)b->next_in;
+    decoded = size - b->avail_out;
+    if (res == BZ_STREAM_END)
+      decoded_to_end = true;
+    else if (res != BZ_OK)
+      decoding_failed("invalid data");
+  } break;
+#endif
+#ifdef HAVE_ZSTD
+  case ZSTD: {
+    ZSTD_inBuffer in = {compressed.begin, available, 0};
+    ZSTD_outBuffer out = {start, size, decoded};
+    size_t res = ZSTD_decompressStream(zstd_stream, &out, &in);
+    compressed.begin += in.pos;
+    decoded = out.pos;
+    if (ZSTD_isError(res))
+      decoding_failed(ZSTD_getErrorName(res));
+    decoded_to_end = !res;
+  } break;
+#endif
+  default:
+    (void)available;
+    assert(!"unexpected decoder");
+    break;
+  }
+  return decoded;
+}
+
+// Decode the next chunk into 'start' and return the number of decoded
+// bytes, which is only zero at the end of the compressed input.
+
+static size_t decompress(unsigned char *start, size_t size) {
+  size_t decoded = 0;
+  while (decoded < size) {
+    if (compressed.begin != compressed.end || refill_compressed())
+      decoded = decode_chunk(start, size, decoded);
+    else if (decoded_to_end)
+      break;
+    else {
+      const size_t before = decoded;
+      decoded = decode_chunk(start, size, decoded);
+      if (decoded == before && !decoded_to_end)
+        decoding_failed("truncated file");
+    }
+  }
+  return decoded;
+}
+
+// Block-parallel decompression of memory mapped files.  Multi-member gzip
+// files written by 'bgzip' store the size of each member in its header and
+// the size of zstd frames can be determined from their block headers.  The
+// compressed file is split along these boundaries into parts which are
+// decoded concurrently by worker threads into their own output buffers.
+// The parts are handed to the parser in file order.  Multi-threaded xz
+// decompression is provided by 'liblzma' itself (see 'init_decoder').
+
+#define PART_SIZE (1u << 22)
+
+struct part {
+  const unsigned char *begin, *end;
+  unsigned char *output;
+  size_t size, allocated;
+  const char *error;
+  bool decoded;
+};
+
+STATE struct {
+  pthread_mutex_t lock;
+  pthread_cond_t decoded, released;
+  pthread_t *threads;
+  unsigned count;
+  struct part *parts;
+  size_t window, scheduled, delivered;
+  const unsigned char *next;
+  bool holding, stop;
+  double time;
+} parallel;
+
+STATE double decompression_time;
+STATE double parsing_started;
+
+static double wall_clock_time(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts))
+    return 0;
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+
+// Returns the size of a 'bgzip' member, i.e., a gzip member with a 'BC'
+// extra field containing the size of the member, and zero otherwise.
+
+static size_t bgzip_member_size(const unsigned char *p, size_t available) {
+  if (available < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 ||
+      !(p[3] & 4))
+    return 0;
+  const size_t extra = p[10] | (size_t)p[11] << 8;
+  if (available < 12 + extra)
+    return 0;
+  for (const unsigned char *q = p + 12, *end = q + extra; q + 4 <= end;) {
+    const size_t length = q[2] | (size_t)q[3] << 8;
+    if (q[0] == 'B' && q[1] == 'C' && length == 2 && q + 6 <= end) {
+      const size_t size = (q[4] | (size_t)q[5] << 8) + 1;
+      return size <= available ? size : 0;
+    }
+    q += 4 + length;
+  }
+  return 0;
+}
+
+// Find the end of the next part starting at 'p'.  If the boundary of the
+// next member or frame can not be determined the rest of the file is
+// decoded as one part (which then also reports errors in order).
+
+static const unsigned char *split_part(const unsigned char *p) {
+  const unsigned char *end = mapped.end;
+  const unsigned char *start = p;
+  while (p != end && (size_t)(p - start) < PART_SIZE) {
+    size_t size = 0;
+#ifdef HAVE_ZLIB
+    if (decoder == GZIP)
+      size = bgzip_member_size(p, end - p);
+#endif
+#ifdef HAVE_ZSTD
+    if (decoder == ZSTD) {
+      size = ZSTD_findFrameCompressedSize(p, end - p);
+      if (ZSTD_isError(size))
+        size = 0;
+    }
+#endif
+    if (!size)
+      return end;
+    p += size;
+  }
+  return p;
+}
+
+// Parts are decoded by worker threads, which thus can not exit on errors
+// but leave them in 'error' to be reported by the parser in file order.
+
+static bool enlarge_part(struct part *part) {
+  size_t new_allocated = part->allocated ? 2 * part->allocated : 1u << 16;
+  void *new_output = realloc(part->output, new_allocated);
+  if (!new_output) {
+    part->error = "out-of-memory reallocating decompressed part";
+    return false;
+  }
+  part->output = new_output;
+  part->allocated = new_allocated;
+  return true;
+}
+
+static void decode_part(struct part *part) {
+  part->size = 0;
+  part->error = 0;
+  const unsigned char *p = part->begin;
+#ifdef HAVE_ZLIB
+  if (decoder == GZIP) {
+    z_stream z;
+    memset(&z, 0, sizeof z);
+    if (inflateInit2(&z, 15 + 16) != Z_OK) {
+      part->error = "could not initialize 'zlib' decompressor";
+      return;
+    }
+    int res = Z_STREAM_END;
+    while (!part->error && (p != part->end || res != Z_STREAM_END)) {
+      if (res == Z_STREAM_END)
+        inflateReset(&z);
+      if (part->size == part->allocated && !enlarge_part(part))
+        break;
+      const size_t available = part->end - p;
+      z.next_in = (unsigned char *)p;
+      z.avail_in = available < UINT_MAX ? available : UINT_MAX;
+      z.next_out = part->output + part->size;
+      z.avail_out = part->allocated - part->size;
+      res = inflate(&z, Z_NO_FLUSH);
+      const bool progress = z.next_in != p || !z.avail_out;
+      p = z.next_in;
+      part->size = part->allocated - z.avail_out;
+      if (res != Z_OK && res != Z_BUF_ERROR && res != Z_STREAM_END)
+        part->error = z.msg ? z.msg : "invalid data";
+      else if (!progress && res != Z_STREAM_END)
+        part->error = "truncated file";
+    }
+    inflateEnd(&z);
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if (decoder == ZSTD) {
+    ZSTD_DStream *z = ZSTD_createDStream();
+    if (!z) {
+      part->error = "could not initialize 'libzstd' decompressor";
+      return;
+    }
+    size_t res = 0;
+    while (!part->error && (p != part->end || res)) {
+      if (part->size == part->allocated && !enlarge_part(part))
+        break;
+      ZSTD_inBuffer in = {p, part->end - p, 0};
+      ZSTD_outBuffer out = {part->output, part->allocated, part->size};
+      res = ZSTD_decompressStream(z, &out, &in);
+      p += in.pos;
+      const bool progress = in.pos || out.pos != part->size;
+      part->size = out.pos;
+      if (ZSTD_isError(res))
+        part->error = ZSTD_getErrorName(res);
+      else if (res && !progress && out.pos != out.size)
+        part->error = "truncated file";
+    }
+    ZSTD_freeDStream(z);
+  }
+#endif
+}
+
+static void *decompress_parts(void *dummy) {
+  (void)dummy;
+  pthread_mutex_lock(&parallel.lock);
+  for (;;) {
+    while (!parallel.stop &&
+           (parallel.next == mapped.end ||
+            parallel.scheduled - parallel.delivered == parallel.window))
+      pthread_cond_wait(&parallel.released, &parallel.lock);
+    if (parallel.stop)
+      break;
+    struct part *part = parallel.parts + parallel.scheduled++ % parallel.window;
+    part->begin = parallel.next;
+    part->end = parallel.next = split_part(parallel.next);
+    part->decoded = false;
+    pthread_mutex_unlock(&parallel.lock);
+    const double start = wall_clock_time();
+    decode_part(part);
+    const double time = wall_clock_time() - start;
+    pthread_mutex_lock(&parallel.lock);
+    parallel.time += time;
+    part->decoded = true;
+    pthread_cond_broadcast(&parallel.decoded);
+  }
+  pthread_mutex_unlock(&parallel.lock);
+  return 0;
+}
+
+// Parts are decoded into buffers of their full decompressed size.  Thus
+// files are only decoded in parallel if the first part ends before the
+// end of the file, e.g., not for single frame zstd or plain gzip files,
+// which are decoded as stream instead.
+
+static bool splittable(const unsigned char *start) {
+  if (decompress_threads < 2 || !mapped.begin)
+    return false;
+  if (decoder != GZIP && decoder != ZSTD)
+    return false;
+  return split_part(start) != mapped.end;
+}
+
+static void start_parallel_decoding(const unsigned char *start) {
+  parallel.count = decompress_threads;
+  parallel.window = 2 * (size_t)parallel.count;
+  parallel.parts = calloc(parallel.window, sizeof *parallel.parts);
+  parallel.threads = calloc(parallel.count, sizeof *parallel.threads);
+  if (!parallel.parts || !parallel.threads)
+    fatal("out-of-memory allocating decompression threads");
+  parallel.scheduled = parallel.delivered = 0;
+  parallel.next = start;
+  parallel.holding = parallel.stop = false;
+  parallel.time = 0;
+  pthread_mutex_init(&parallel.lock, 0);
+  pthread_cond_init(&parallel.decoded, 0);
+  pthread_cond_init(&parallel.released, 0);
+  for (unsigned i = 0; i != parallel.count; i++)
+    if (pthread_create(parallel.threads + i, 0, decompress_parts, 0))
+      fatal("could not start decompression thread");
+  vrb("decompressing '%s' block-parallel with %u threads", path,
+      parallel.count);
+}
+
+static void stop_parallel_decoding(void) {
+  pthread_mutex_lock(&parallel.lock);
+  parallel.stop = true;
+  pthread_cond_broadcast(&parallel.released);
+  pthread_mutex_unlock(&parallel.lock);
+  for (unsigned i = 0; i != parallel.count; i++)
+    pthread_join(parallel.threads[i], 0);
+  vrb("decompression threads spent %.2f seconds decoding", parallel.time);
+  for (size_t i = 0; i != parallel.window; i++)
+    free(parallel.parts[i].output);
+  free(parallel.parts);
+  free(parallel.threads);
+  pthread_mutex_destroy(&parallel.lock);
+  pthread_cond_destroy(&parallel.decoded);
+  pthread_cond_destroy(&parallel.released);
+  memset(&parallel, 0, sizeof parallel);
+}
+
+// Release the part currently read by the parser and wait for the next one.
+// Returns zero at the end of the file.
+
+static struct part *next_decoded_part(void) {
+  pthread_mutex_lock(&parallel.lock);
+  if (parallel.holding) {
+    parallel.delivered++;
+    parallel.holding = false;
+    pthread_cond_broadcast(&parallel.released);
+  }
+  struct part *part = 0;
+  for (;;) {
+    if (parallel.delivered == parallel.scheduled &&
+        parallel.next == mapped.end)
+      break;
+    part = parallel.parts + parallel.delivered % parallel.window;
+    while (parallel.delivered == parallel.scheduled || !part->decoded)
+      pthread_cond_wait(&parallel.decoded, &parallel.lock);
+    if (part->error || part->size)
+      break;
+    parallel.delivered++;
+    pthread_cond_broadcast(&parallel.released);
+    part = 0;
+  }
+  if (part)
+    parallel.holding = true;
+  pthread_mutex_unlock(&parallel.lock);
+  if (!part)
+    return 0;
+  if (part->error)
+    decoding_failed(part->error);
+  release_mapped(part->begin);
+  return part;
+}
+
+#else
+
+static bool splittable(const unsigned char *start) {
+  (void)start;
+  return false;
+}
+
+static void start_parallel_decoding(const unsigned char *start) {
+  (void)start;
+}
+
+static void stop_parallel_decoding(void) {}
+
+static struct part *next_decoded_part(void) { return 0; }
+
+#endif
+
+static bool map_file(void) {
+  struct stat buf;
+  if (fstat(fd, &buf) || !S_ISREG(buf.st_mode) || !buf.st_size)
+    return false;
+  const size_t size = buf.st_size;
+  void *start = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (start == MAP_FAILED)
+    return false;
+  (void)madvise(start, size, MADV_SEQUENTIAL);
+  mapped.begin = start;
+  mapped.end = mapped.begin + size;
+  vrb("memory mapped %zu bytes of '%s'", size, path);
+  return true;
+}
+
+static void unmap_file(void) {
+  if (!mapped.begin)
+    return;
+  if (!mapped_memory)
+    munmap(mapped.begin, mapped.end - mapped.begin);
+  mapped.begin = mapped.end = 0;
+  mapped_memory = false;
+}
+
+static size_t offset_of(const unsigned char *p) {
+  return buffer_offset + (p - buffer.begin);
+}
+
+static const unsigned char *character(size_t offset) {
+  return buffer.begin + (ptrdiff_t)(offset - buffer_offset);
+}
+
+static size_t charno(void) { return offset_of(buffer.pos); }
+
+static void next_buffer(unsigned char *begin, unsigned char *end) {
+  buffer_offset += buffer.end - buffer.begin;
+  buffer.begin = buffer.pos = begin;
+  buffer.end = end;
+}
+
+static size_t count_lines(const unsigned char *p, const unsigned char *end) {
+  size_t res = 0;
+  while ((p = memchr(p, '\n', end - p)))
+    res++, p++;
+  return res;
+}
+
+// Move the line counting cursor from 'p' to 'q' after 'lines' new-lines
+// have been found in '[p, q)', where the last one is just before 'line'.
+
+static void skip_counted(const unsigned char *p, const unsigned char *q,
+                         size_t lines, const unsigned char *line) {
+  assert(offset_of(p) == counted.offset);
+  if (lines > 1) {
+    const unsigned char *previous = line - 1;
+    while (previous[-1] != '\n')
+      previous--;
+    counted.previous = offset_of(previous);
+  } else if (lines)
+    counted.previous = counted.line;
+  if (lines)
+    counted.line = offset_of(line);
+  counted.lines += lines;
+  counted.offset += q - p;
+}
+
+// Count the lines of the characters before 'offset' which have not been
+// counted yet.  Memory mapped plain files stay accessible as a whole while
+// other buffers are counted completely before they are overwritten (see
+// 'refill_buffer').  The parser always requests positions in the current
+// line, which thus can also be located if the cursor is already past it.
+
+static void count_lines_to(size_t offset) {
+  if (offset <= counted.offset)
+    return;
+  const unsigned char *p = character(counted.offset), *q = character(offset);
+  const size_t lines = count_lines(p, q);
+  const unsigned char *line = q;
+  if (lines)
+    while (line[-1] != '\n')
+      line--;
+  skip_counted(p, q, lines, line);
+}
+
+// The column of the character at position 'token' (zero before the first
+// character).  Call it before 'current_line' since lines are only counted
+// forward.
+
+static size_t column_of(size_t token) {
+  if (!token)
+    return 0;
+  count_lines_to(token - 1);
+  size_t line = counted.line;
+  if (line > token - 1)
+    line = counted.previous;
+  return token - line;
+}
+
+// The line of the last read character or at the end of the file the
+// number of lines read plus one.
+
+static size_t current_line(void) {
+  const size_t read = charno();
+  count_lines_to(end_of_file || !read ? read : read - 1);
+  return counted.lines + 1;
+}
+
+// Pipelined parsing of the clause section.  A reader thread fills blocks
+// of input (reading, decompressing, or touching the pages of the mapped
+// file), the tokenizer thread runs the sequential clause parser on these
+// blocks and hands over the parsed literals and clause positions in
+// batches to the consumer (the main thread), which stores the clauses or
+// checks them in model-first mode.  The stages are connected by lock-free
+// single-producer / single-consumer rings.  Before the tokenizer reports
+// any warning or error it waits until all clauses parsed before have been
+// consumed, which gives the same diagnostics as sequential parsing.
+
+#define RING_SIZE 4
+#define BATCH_SIZE (1u << 16)
+
+struct ring {
+  atomic_size_t produced, consumed;
+};
+
+struct block {
+  unsigned char *begin, *end;
+  unsigned char *storage;
+  size_t allocated;
+  const char *error;
+};
+
+struct batch {
+  int *literals;
+  struct position *positions;
+  size_t size, clauses;
+  bool last;
+};
+
+STATE struct {
+  struct ring input, output;
+  struct block blocks[RING_SIZE];
+  struct batch batches[RING_SIZE];
+  struct batch *batch;
+  pthread_t reader, tokenizer;
+  unsigned char *mapped;
+  size_t reading;
+  bool holding, end_of_input;
+  double reader_stalled, input_stalled, output_stalled, consumer_stalled;
+} pipeline;
+
+static __thread bool tokenizing;
+
+// Returns the slot to be filled next by the producer and the slot to be
+// read next by the consumer of a ring.  Both wait (yielding the processor)
+// as long as the ring is full respectively empty and add the time spent
+// waiting to the given stall time of the calling stage.
+
+static size_t produce_slot(struct ring *ring, double *stalled) {
+  const size_t produced =
+      atomic_load_explicit(&ring->produced, memory_order_relaxed);
+  if (produced - atomic_load_explicit(&ring->consumed, memory_order_acquire) ==
+      RING_SIZE) {
+    const double start = wall_clock_time();
+    while (produced - atomic_load_explicit(&ring->consumed,
+                                           memory_order_acquire) == RING_SIZE)
+      sched_yield();
+    *stalled += wall_clock_time() - start;
+  }
+  return produced % RING_SIZE;
+}
+
+static void produced_slot(struct ring *ring) {
+  atomic_fetch_add_explicit(&ring->produced, 1, memory_order_release);
+}
+
+static size_t consume_slot(struct ring *ring, double *stalled) {
+  const size_t consumed =
+      atomic_load_explicit(&ring->consumed, memory_order_relaxed);
+  if (atomic_load_explicit(&ring->produced, memory_order_acquire) ==
+      consumed) {
+    const double start = wall_clock_time();
+    while (atomic_load_explicit(&ring->produced, memory_order_acquire) ==
+           consumed)
+      sched_yield();
+    *stalled += wall_clock_time() - start;
+  }
+  return consumed % RING_SIZE;
+}
+
+static void consumed_slot(struct ring *ring) {
+  atomic_fetch_add_explicit(&ring->consumed, 1, memory_order_release);
+}
+
+static void enlarge_block(struct block *block, size_t size) {
+  if (size <= block->allocated)
+    return;
+  free(block->storage);
+  if (!(block->storage = malloc(size)))
+    fatal("out-of-memory allocating pipeline block");
+  block->allocated = size;
+}
+
+// Fill the next block and return 'false' at the end of the input.  Parts
+// of block-parallel decompression are copied since they are released as
+// soon as the next part is requested.  For memory mapped plain files the
+// pages of the block are touched in order to overlap page faults too.
+
+static bool read_block(struct block *block) {
+  size_t bytes;
+  block->error = 0;
+  if (parallel.count) {
+    const struct part *part = next_decoded_part();
+    if (!part) {
+      block->begin = block->end = 0;
+      return false;
+    }
+    enlarge_block(block, part->size);
+    memcpy(block->storage, part->output, part->size);
+    bytes = part->size;
+  } else if (format != PLAIN) {
+    enlarge_block(block, STREAM_BUFFER_SIZE);
+    if (in_process_decoder(decoder))
+      bytes = decompress(block->storage, STREAM_BUFFER_SIZE);
+    else
+      bytes = read_input(block->storage, STREAM_BUFFER_SIZE);
+  } else if (mapped.begin) {
+    unsigned char *begin = pipeline.mapped, *end = mapped.end;
+    if ((size_t)(end - begin) > STREAM_BUFFER_SIZE)
+      end = begin + STREAM_BUFFER_SIZE;
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    unsigned sum = 0;
+    for (const volatile unsigned char *p = begin; p < end; p += page_size)
+      sum += *p;
+    (void)sum;
+    block->begin = begin;
+    block->end = pipeline.mapped = end;
+    return begin != end;
   } else {
-    if (ch != ' ' && ch != '\t')
-      err(column, "expected %s or %s after 'cnf'", space_name(' '),
-          space_name('\t'));
-    do
-      ch = next_char();
-    while (ch == ' ' || ch == '\t');
+    enlarge_block(block, STREAM_BUFFER_SIZE);
+    bytes = read_input(block->storage, STREAM_BUFFER_SIZE);
+  }
+  block->begin = block->storage;
+  block->end = block->storage + bytes;
+  return bytes;
+}
+
+static void *read_blocks(void *dummy) {
+  (void)dummy;
+  reading_ahead = true;
+  if (setjmp(reading_failed)) {
+    struct block *block = pipeline.blocks + pipeline.reading;
+    block->begin = block->end = 0;
+    block->error = input_error;
+    produced_slot(&pipeline.input);
+    return 0;
+  }
+  for (;;) {
+    pipeline.reading =
+        produce_slot(&pipeline.input, &pipeline.reader_stalled);
+    const bool read = read_block(pipeline.blocks + pipeline.reading);
+    produced_slot(&pipeline.input);
+    if (!read)
+      return 0;
+  }
+}
+
+// Slow path of 'next_char' in the tokenizer thread.
+
+static int next_input_block(void) {
+  if (pipeline.end_of_input)
+    return EOF;
+  if (pipeline.holding)
+    consumed_slot(&pipeline.input);
+  const size_t slot = consume_slot(&pipeline.input, &pipeline.input_stalled);
+  struct block *block = pipeline.blocks + slot;
+  if (block->error) {
+    synchronize_pipeline();
+    die("%s", block->error);
+  }
+  if (block->begin == block->end) {
+    consumed_slot(&pipeline.input);
+    pipeline.holding = false;
+    pipeline.end_of_input = true;
+    return EOF;
+  }
+  pipeline.holding = true;
+  if (format == PLAIN && mapped.begin)
+    release_mapped(block->begin);
+  next_buffer(block->begin, block->end);
+  return *buffer.pos++;
+}
+
+static struct batch *tokenizer_batch(void) {
+  struct batch *batch = pipeline.batch;
+  if (batch)
+    return batch;
+  const size_t slot = produce_slot(&pipeline.output, &pipeline.output_stalled);
+  batch = pipeline.batch = pipeline.batches + slot;
+  batch->size = batch->clauses = 0;
+  batch->last = false;
+  return batch;
+}
+
+static void flush_batch(bool last) {
+  tokenizer_batch()->last = last;
+  pipeline.batch = 0;
+  produced_slot(&pipeline.output);
+}
+
+static void emit_literal(int lit) {
+  struct batch *batch = tokenizer_batch();
+  batch->literals[batch->size++] = lit;
+  if (batch->size == BATCH_SIZE)
+    flush_batch(false);
+}
+
+static void emit_clause(size_t lineno, size_t column) {
+  struct batch *batch = tokenizer_batch();
+  struct position *position = batch->positions + batch->clauses++;
+  position->lineno = lineno;
+  position->column = column;
+  batch->literals[batch->size++] = 0;
+  if (batch->size == BATCH_SIZE)
+    flush_batch(false);
+}
+
+// Called before diagnostics are printed.  In the tokenizer thread it waits
+// until all clauses parsed so far have been stored or checked.  Thus a
+// clause violated by the model is reported before any later parse error.
+
+static void synchronize_pipeline(void) {
+  if (!tokenizing)
+    return;
+  flush_batch(false);
+  const size_t produced =
+      atomic_load_explicit(&pipeline.output.produced, memory_order_relaxed);
+  while (atomic_load_explicit(&pipeline.output.consumed,
+                              memory_order_acquire) != produced)
+    sched_yield();
+}
+
+static void init_parsing(const char *p) {
+  if (memory.begin) {
+    path = memory.name;
+    fd = -1;
+    close_file = 0;
+  } else if (!strcmp(p, "-")) {
+    path = "<stdin>";
+    fd = 0;
+    close_file = 0;
+  } else {
+    path = p;
+    double idle = 0;
+    unsigned delay = 1;
+    while ((fd = open(p, O_RDONLY)) < 0 && tailing && errno == ENOENT &&
+           wait_for_input(&idle, &delay))
+      ;
+    if (fd < 0 && !strncmp(p, "/dev/fd/", 8) && '0' <= p[8] && p[8] <= '9')
+      fd = dup(atoi(p + 8));
+    if (fd < 0)
+      die("can not open and read '%s'", path);
+    close_file = 1;
+  }
+  struct stat buf;
+  if (tailing && (fstat(fd, &buf) || !S_ISREG(buf.st_mode)))
+    tailing = false;
+  if (!stream_buffer && !(stream_buffer = malloc(STREAM_BUFFER_SIZE)))
+    fatal("out-of-memory allocating input buffer");
+  const unsigned char *start;
+  size_t bytes = 0;
+  if (memory.begin) {
+    mapped.begin = (unsigned char *)memory.begin;
+    mapped.end = (unsigned char *)memory.end;
+    mapped_memory = true;
+    memory.begin = memory.end = 0;
+    start = mapped.begin;
+    bytes = mapped.end - mapped.begin;
+  } else if (!tailing && map_file()) {
+    start = mapped.begin;
+    bytes = mapped.end - mapped.begin;
+  } else {
+    start = stream_buffer;
+    size_t read = 0;
+    while (bytes < MAXIMUM_MAGIC_BYTES && (!tailing || !bytes) &&
+           (read = read_input(stream_buffer + bytes,
+                              STREAM_BUFFER_SIZE - bytes)))
+      bytes += read;
+  }
+  parsing_started = wall_clock_time();
+  decompression_time = 0;
+  format = detect_format(start, bytes);
+  if (format == PLAIN) {
+    for (size_t f = PLAIN + 1; f != NUMBER_OF_FORMATS; f++)
+      if (has_suffix(p, formats[f].suffix))
+        wrn("file has '%s' suffix but is not %s compressed "
+            "(reading it uncompressed)",
+            formats[f].suffix, formats[f].name);
+    buffer.begin = buffer.pos = (unsigned char *)start;
+    buffer.end = mapped.begin ? buffer.begin : buffer.begin + bytes;
+  } else if (in_process_decoder(format)) {
+    vrb("decompressing %s compressed '%s' in-process", formats[format].name,
+        path);
+    decoder = format;
+    init_decoder();
+    if (mapped.begin)
+      compressed.begin = start;
+    else {
+      if (!compressed_buffer &&
+          !(compressed_buffer = malloc(STREAM_BUFFER_SIZE)))
+        fatal("out-of-memory allocating decompression buffer");
+      memcpy(compressed_buffer, start, bytes);
+      compressed.begin = compressed_buffer;
+    }
+    compressed.end = compressed.begin + bytes;
+    buffer.begin = buffer.pos = buffer.end = stream_buffer;
+    if (splittable(start))
+      start_parallel_decoding(start);
+    else if (decompress_threads > 1 && format != XZ)
+      vrb("can not decompress '%s' block-parallel", path);
+  } else {
+    if (!close_file)
+      die("can not decompress %s compressed '%s' without library",
+          formats[format].name, path);
+    vrb("decompressing %s compressed '%s' through pipe from '%s'",
+        formats[format].name, path, formats[format].tool);
+    unmap_file();
+    close(fd);
+    file = read_zipped(formats[format].tool, p);
+    if (!file)
+      die("can not open and read '%s'", path);
+    fd = fileno(file);
+    close_file = 2;
+    buffer.begin = buffer.pos = buffer.end = stream_buffer;
+  }
+  buffer_offset = 0;
+  end_of_file = false;
+  memset(&counted, 0, sizeof counted);
+}
+
+static void reset_parsing(void) {
+  vrb("closing '%s'", path);
+  if (parallel.count)
+    stop_parallel_decoding();
+  if (format != PLAIN) {
+    const double total = wall_clock_time() - parsing_started;
+    const double parsing = total - decompression_time;
+    msg("decompression took %.2f seconds (%.0f%%) and parsing %.2f seconds "
+        "(%.0f%%)",
+        decompression_time, percent(decompression_time, total), parsing,
+        percent(parsing, total));
+  }
+  reset_decoder();
+  unmap_file();
+  if (close_file == 1)
+    close(fd);
+  if (close_file == 2)
+    pclose(file);
+  close_file = 0;
+}
+
+// Slow path of 'next_char' if the buffer is exhausted.  For memory mapped
+// plain files this moves the window forward and releases the pages of the
+// old window.  Otherwise the next chunk is decompressed or read.  The time
+// spent on decompression (or waiting for it) is accumulated separately.
+
+static int refill_buffer(void) {
+  size_t bytes;
+  if (format != PLAIN || !mapped.begin)
+    count_lines_to(charno());
+  if (tokenizing)
+    return next_input_block();
+  else if (parallel.count) {
+    const double start = wall_clock_time();
+    const struct part *part = next_decoded_part();
+    decompression_time += wall_clock_time() - start;
+    if (!part)
+      return EOF;
+    next_buffer(part->output, part->output + part->size);
+    return *buffer.pos++;
+  } else if (format != PLAIN) {
+    const double start = wall_clock_time();
+    if (in_process_decoder(decoder))
+      bytes = decompress(stream_buffer, STREAM_BUFFER_SIZE);
+    else
+      bytes = read_input(stream_buffer, STREAM_BUFFER_SIZE);
+    decompression_time += wall_clock_time() - start;
+  } else if (mapped.begin) {
+    if (buffer.end == mapped.end)
+      return EOF;
+    release_mapped(buffer.end);
+    if ((size_t)(mapped.end - buffer.end) > MAPPED_WINDOW_SIZE)
+      next_buffer(buffer.end, buffer.end + MAPPED_WINDOW_SIZE);
+    else
+      next_buffer(buffer.end, mapped.end);
+    return *buffer.pos++;
+  } else
+    bytes = read_input(stream_buffer, STREAM_BUFFER_SIZE);
+  if (!bytes)
+    return EOF;
+  next_buffer(stream_buffer, stream_buffer + bytes);
+  return *buffer.pos++;
+}
+
+static int next_char(void) {
+  if (buffer.pos != buffer.end)
+    return *buffer.pos++;
+  const int res = refill_buffer();
+  end_of_file = (res == EOF);
+  return res;
+}
+
+static bool is_space(int ch) {
+  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+static bool is_digit(int ch) { return '0' <= ch && ch <= '9'; }
+
+static const char *space_name(int ch) {
+  assert(is_space(ch));
+  if (ch == ' ')
+    return "space ' '";
+  if (ch == '\t')
+    return "tab-character '\\t'";
+  if (ch == '\r')
+    return "carriage-return '\\r'";
+  assert(ch == '\n');
+  return "new-line '\\n'";
+}
+
+// Chunk-parallel parsing of the clause section of memory mapped files.
+// The clause section is split at new-lines into chunks, which are
+// tokenized concurrently.  Each thread builds the clauses completely
+// contained in its chunk.  The literals before the first and after the
+// last terminating zero of a chunk are kept separately as 'head' and
+// 'tail', since these clauses might span chunk boundaries (in relaxed
+// mode), and are stitched together during merging in file order.
+//
+// Parsing a chunk only succeeds for input which is correct and does not
+// trigger a warning.  If any chunk fails, all results are discarded and
+// the sequential parser is run instead on the whole clause section, which
+// then produces exactly the same diagnostics as without threads.  Clause
+// positions are not needed, since memory mapped files can be read again.
+
+#define MINIMUM_CHUNK_SIZE (1u << 20)
+
+struct tokens {
+  int *begin, *end, *allocated;
+};
+
+struct chunk {
+  const unsigned char *begin, *end;
+  struct tokens head, tail, literals;
+  bool closed;
+  struct {
+    size_t *begin, *end, *allocated;
+  } ends;
+  int maximum_variable;
+  bool failed;
+};
+
+STATE struct {
+  size_t specified_variables;
+  struct chunk *chunks;
+  bool failed;
+} chunks;
+
+static void push_token(struct tokens *tokens, int lit) {
+  if (tokens->end == tokens->allocated) {
+    const size_t old_capacity = tokens->allocated - tokens->begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 16;
+    void *new_begin = realloc(tokens->begin, new_capacity * sizeof(int));
+    if (!new_begin)
+      fatal("out-of-memory reallocating chunk tokens");
+    tokens->begin = new_begin;
+    tokens->end = tokens->begin + old_capacity;
+    tokens->allocated = tokens->begin + new_capacity;
+  }
+  *tokens->end++ = lit;
+}
+
+// The clauses in between 'head' and 'tail' follow each other in 'literals'
+// and 'ends' holds the end offset of each clause.
+
+static void push_chunk_end(struct chunk *chunk) {
+  if (chunk->ends.end == chunk->ends.allocated) {
+    const size_t old_capacity = chunk->ends.allocated - chunk->ends.begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 1024;
+    void *new_begin = realloc(chunk->ends.begin, new_capacity * sizeof(size_t));
+    if (!new_begin)
+      fatal("out-of-memory reallocating chunk clause ends");
+    chunk->ends.begin = new_begin;
+    chunk->ends.end = chunk->ends.begin + old_capacity;
+    chunk->ends.allocated = chunk->ends.begin + new_capacity;
+  }
+  *chunk->ends.end++ = chunk->literals.end - chunk->literals.begin;
+}
+
+static void *parse_chunk(void *ptr) {
+  struct chunk *chunk = ptr;
+  const unsigned char *p = chunk->begin, *end = chunk->end;
+  const size_t specified_variables = chunks.specified_variables;
+  struct tokens *tokens = &chunk->head;
+  int maximum_variable = 0;
+  bool failed = false;
+  size_t lines = 0;
+  for (;;) {
+    if (!strict) {
+      while (p != end && (is_space(*p) || *p == 'c')) {
+        if (*p == 'c') {
+          p = memchr(p, '\n', end - p);
+          if (!p) {
+            failed = true;
+            break;
+          }
+        }
+        if (*p++ == '\n' && !(++lines & 0xffff) &&
+            __atomic_load_n(&chunks.failed, 0)) {
+          failed = true;
+          break;
+        }
+      }
+      if (failed)
+        break;
+    }
+    if (p == end)
+      break;
+    int sign = 1;
+    if (*p == '-') {
+      sign = -1;
+      if (++p == end || (strict && *p == '0')) {
+        failed = true;
+        break;
+      }
+    }
+    if (p == end || !is_digit(*p)) {
+      failed = true;
+      break;
+    }
+    size_t idx = *p++ - '0';
+    while (p != end && is_digit(*p)) {
+      if ((strict && !idx) || idx > INT_MAX / 10)
+        break;
+      idx = 10 * idx + (*p++ - '0');
+    }
+    if (p == end || idx > INT_MAX || idx > specified_variables) {
+      failed = true;
+      break;
+    }
+    if (strict) {
+      if (idx && *p == ' ')
+        p++;
+      else if (!idx && *p == '\n')
+        p++;
+      else if (!idx && *p == '\r' && p + 1 != end && p[1] == '\n')
+        p += 2;
+      else {
+        failed = true;
+        break;
+      }
+    } else if (!is_space(*p) && *p != 'c') {
+      failed = true;
+      break;
+    }
+    if (idx) {
+      push_token(tokens, sign * (int)idx);
+      if ((int)idx > maximum_variable)
+        maximum_variable = idx;
+    } else if (tokens == &chunk->head) {
+      chunk->closed = true;
+      tokens = &chunk->literals;
+    } else
+      push_chunk_end(chunk);
+  }
+  if (!failed && tokens == &chunk->literals) {
+    int *tail = tokens->begin;
+    if (chunk->ends.end != chunk->ends.begin)
+      tail += chunk->ends.end[-1];
+    for (const int *p = tail; p != tokens->end; p++)
+      push_token(&chunk->tail, *p);
+    tokens->end = tail;
+  }
+  chunk->maximum_variable = maximum_variable;
+  if ((chunk->failed = failed))
+    __atomic_store_n(&chunks.failed, true, 0);
+  return 0;
+}
+
+static void run_chunk_threads(size_t count, void *(*function)(void *)) {
+  pthread_t *threads = calloc(count, sizeof *threads);
+  if (!threads)
+    fatal("out-of-memory allocating parser threads");
+  for (size_t i = 0; i != count; i++)
+    if (pthread_create(threads + i, 0, function, chunks.chunks + i))
+      fatal("could not start parser thread");
+  for (size_t i = 0; i != count; i++)
+    pthread_join(threads[i], 0);
+  free(threads);
+}
+
+static void release_chunks(size_t count) {
+  for (struct chunk *c = chunks.chunks; c != chunks.chunks + count; c++) {
+    free(c->ends.begin);
+    free(c->literals.begin);
+    free(c->head.begin);
+    free(c->tail.begin);
+  }
+  free(chunks.chunks);
+  chunks.chunks = 0;
+}
+
+static void push_clause_literals(const struct tokens *tokens) {
+  for (const int *p = tokens->begin; p != tokens->end; p++)
+    push_literal(*p);
+}
+
+// Try to parse the rest of the clause section in parallel starting with
+// the (already read) character 'ch'.  Returns 'true' if successful, in
+// which case all clauses have been added and the input is at its end.
+
+static bool parse_clauses_in_parallel(int ch) {
+  if (parse_threads < 2 || !mapped.begin || format != PLAIN || ch == EOF ||
+      verbosity == INT_MAX || model_first || tokenizing || clause_positions ||
+      locating)
+    return false;
+  const unsigned char *begin = buffer.pos - 1, *end = mapped.end;
+  assert(mapped.begin <= begin && *begin == ch);
+  size_t count = (end - begin) / MINIMUM_CHUNK_SIZE;
+  if (count > parse_threads)
+    count = parse_threads;
+  if (count < 2)
+    return false;
+  chunks.chunks = calloc(count, sizeof *chunks.chunks);
+  if (!chunks.chunks)
+    fatal("out-of-memory allocating chunks");
+  chunks.specified_variables = specified_variables;
+  chunks.failed = false;
+  const unsigned char *p = begin;
+  const size_t size = (end - begin) / count;
+  for (size_t i = 0; i != count; i++) {
+    struct chunk *chunk = chunks.chunks + i;
+    chunk->begin = p;
+    if (i + 1 == count)
+      p = end;
+    else if (p < begin + (i + 1) * size) {
+      p = memchr(begin + (i + 1) * size, '\n', end - begin - (i + 1) * size);
+      p = p ? p + 1 : end;
+    }
+    chunk->end = p;
+  }
+  vrb("parsing clauses in %zu chunks with %zu threads", count, count);
+  run_chunk_threads(count, parse_chunk);
+  size_t clauses_in_chunks = 0;
+  bool open = false;
+  for (size_t i = 0; !chunks.failed && i != count; i++) {
+    const struct chunk *chunk = chunks.chunks + i;
+    if (chunk->closed) {
+      clauses_in_chunks++;
+      open = false;
+    }
+    clauses_in_chunks += chunk->ends.end - chunk->ends.begin;
+    if (chunk->tail.end != chunk->tail.begin)
+      open = true;
+    else if (!chunk->closed && chunk->head.end != chunk->head.begin)
+      open = true;
+  }
+  if (chunks.failed || open ||
+      (strict && parsed_clauses + clauses_in_chunks > specified_clauses)) {
+    vrb("parallel parsing failed (falling back to sequential parsing)");
+    release_chunks(count);
+    return false;
+  }
+  for (size_t i = 0; i != count; i++) {
+    struct chunk *chunk = chunks.chunks + i;
+    if (chunk->head.end != chunk->head.begin || chunk->closed)
+      push_clause_literals(&chunk->head);
+    if (chunk->closed) {
+      parsed_clauses++;
+      push_clause(0, 0);
+      clear_literals();
+    }
+    const int *begin = chunk->literals.begin;
+    for (const size_t *e = chunk->ends.begin; e != chunk->ends.end; e++) {
+      const int *end = chunk->literals.begin + *e;
+      add_clause(begin, end);
+      begin = end;
+    }
+    parsed_clauses += chunk->ends.end - chunk->ends.begin;
+    if (chunk->tail.end != chunk->tail.begin)
+      push_clause_literals(&chunk->tail);
+    if (chunk->maximum_variable > maximum_dimacs_variable)
+      maximum_dimacs_variable = chunk->maximum_variable;
+  }
+  assert(!size_literals());
+  release_chunks(count);
+  buffer_offset = end - mapped.begin;
+  buffer.begin = buffer.pos = buffer.end = mapped.end;
+  return true;
+}
+
+// With '--all-violations' all unsatisfied clauses and in complete mode all
+// missing values are collected instead of stopping at the first one.  All
+// of them are counted (clauses also by size) but only the first 'limit' are
+// recorded for reporting.  Recorded clauses keep their position and their
+// literals, which start at 'offset' in 'literals'.  Positions which are not
+// known are found by parsing the DIMACS file again (see 'locate_violations'),
+// which also gives the original order of literals of compacted clauses.
+
+#define EXACT_SIZES 16
+
+STATE struct {
+  bool enabled;
+  size_t limit, unsatisfied, missing;
+  struct violation {
+    size_t idx, lineno, column, offset, size;
+  } *begin, *end, *allocated, *locating;
+  struct {
+    int *begin;
+    size_t size, capacity;
+  } literals;
+  struct {
+    size_t *begin, *end, *allocated;
+  } variables;
+  size_t sizes[EXACT_SIZES + 64];
+} violations;
+
+// Clauses with less than 'EXACT_SIZES' literals are counted by their exact
+// size and others by the binary logarithm of their size.
+
+static unsigned size_bucket(size_t size) {
+  if (size < EXACT_SIZES)
+    return size;
+  return EXACT_SIZES + (63 - __builtin_clzll(size)) - 4;
+}
+
+static void record_unsatisfied_clause(size_t lineno, size_t column,
+                                      size_t idx, const int *begin,
+                                      const int *end) {
+  const size_t size = end - begin;
+  violations.unsatisfied++;
+  violations.sizes[size_bucket(size)]++;
+  if ((size_t)(violations.end - violations.begin) == violations.limit)
+    return;
+  if (violations.end == violations.allocated) {
+    const size_t old_capacity = violations.allocated - violations.begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 16;
+    void *new_begin =
+        realloc(violations.begin, new_capacity * sizeof *violations.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating violations");
+    violations.begin = new_begin;
+    violations.end = violations.begin + old_capacity;
+    violations.allocated = violations.begin + new_capacity;
+  }
+  const size_t offset = violations.literals.size;
+  if (violations.literals.capacity - offset < size) {
+    size_t new_capacity = violations.literals.capacity;
+    if (!new_capacity)
+      new_capacity = 64;
+    while (new_capacity - offset < size)
+      new_capacity *= 2;
+    void *new_begin = realloc(violations.literals.begin,
+                              new_capacity * sizeof *violations.literals.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating literals of violations");
+    violations.literals.begin = new_begin;
+    violations.literals.capacity = new_capacity;
+  }
+  if (size)
+    memcpy(violations.literals.begin + offset, begin, size * sizeof *begin);
+  violations.literals.size = offset + size;
+  struct violation *v = violations.end++;
+  v->idx = idx, v->lineno = lineno, v->column = column;
+  v->offset = offset, v->size = size;
+}
+
+static void record_missing_variable(size_t idx) {
+  violations.missing++;
+  if ((size_t)(violations.variables.end - violations.variables.begin) ==
+      violations.limit)
+    return;
+  if (violations.variables.end == violations.variables.allocated) {
+    const size_t old_capacity =
+        violations.variables.allocated - violations.variables.begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 16;
+    void *new_begin =
+        realloc(violations.variables.begin,
+                new_capacity * sizeof *violations.variables.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating missing variables");
+    violations.variables.begin = new_begin;
+    violations.variables.end = violations.variables.begin + old_capacity;
+    violations.variables.allocated = violations.variables.begin + new_capacity;
+  }
+  *violations.variables.end++ = idx;
+}
+
+// Checks 32 variables at once, i.e., one word of the value table, where
+// the lower bit of each pair of bits is cleared if the variable is assigned.
+// Variables beyond the value table are checked one-by-one (being sparse).
+
+static void check_completeness(void) {
+  msg("checking completeness of model (due to '%s')", complete_option);
+  const uint64_t pairs = 0x5555555555555555;
+  const size_t maximum_variable = maximum_dimacs_variable;
+  for (size_t first = 0; first <= maximum_variable; first += 32) {
+    uint64_t missing = 0;
+    if (first + 32 <= values.size) {
+      const uint64_t word = values.begin[first / 32];
+      missing = ~(word | word >> 1) & pairs;
+    } else
+      for (unsigned i = 0; i != 32; i++)
+        if (!value_of(first + i))
+          missing |= (uint64_t)1 << (2 * i);
+    if (!first)
+      missing &= ~(uint64_t)1;
+    if (maximum_variable - first < 31)
+      missing &= ((uint64_t)1 << (2 * (maximum_variable - first + 1))) - 1;
+    if (missing && !violations.enabled) {
+      library.status = DIMOCHECK_UNSATISFIED;
+      die("complete checking mode: "
+          "value for DIMACS variable '%zu' missing",
+          first + __builtin_ctzll(missing) / 2);
+    }
+    for (; missing; missing &= missing - 1)
+      record_missing_variable(first + __builtin_ctzll(missing) / 2);
+  }
+  if (!violations.missing)
+    msg("model complete (all DIMACS variables are assigned)");
+}
+
+static void print_unsatisfied_clause(size_t lineno, size_t column,
+                                     size_t idx, const int *begin,
+                                     const int *end) {
+  if (!library.clause) {
+    library.clause = idx;
+    library.lineno = lineno, library.column = column;
+  }
+  fprintf(errors, "%s:%zu:%zu: error: clause[%zu] unsatisfied:\n",
+          dimacs_path, lineno, column, idx);
+  for (const int *q = begin; q != end; q++)
+    fprintf(errors, "%d ", *q);
+  fputs("0\n", errors);
+  fflush(errors);
+}
+
+static void check_clause(size_t lineno, size_t column, size_t idx,
+                         const int *begin, const int *end) {
+  const int *q = begin;
+  bool satisfied = false;
+  while (!satisfied && q != end) {
+    const int lit = *q++;
+    assert(lit != INT_MIN);
+    if (!falsified(lit))
+      satisfied = true;
+  }
+  if (satisfied)
+    return;
+  if (violations.enabled) {
+    record_unsatisfied_clause(lineno, column, idx, begin, end);
+    return;
+  }
+  if (!lineno)
+    locate_unsatisfied_clause(idx);
+  print_unsatisfied_clause(lineno, column, idx, begin, end);
+  failed(DIMOCHECK_UNSATISFIED);
+}
+
+static void located_violation(size_t, size_t);
+
+static void store_clause(size_t lineno, size_t column, size_t idx) {
+  if (locating) {
+    if (idx != locating)
+      return;
+    if (violations.enabled)
+      located_violation(lineno, column);
+    else
+      check_clause(lineno, column, idx, literals.begin, literals.end);
+  } else if (model_first)
+    check_clause(lineno, column, idx, literals.begin, literals.end);
+  else
+    push_clause(lineno, column);
+}
+
+// Parses the DIMACS header and returns the first character after it.
+
+static int parse_dimacs_header(void) {
+  init_parsing(dimacs_path);
+  msg("parsing DIMACS '%s'", path);
+  if (strict) {
+    assert(strict_option);
+    msg("parsing in strict mode (due to '%s')", strict_option);
+  } else
+    msg("parsing in relaxed mode (without '--strict' nor '--pedantic')");
+  for (;;) {
+    int ch = next_char();
+    if (ch == EOF) {
+      if (charno())
+        err(charno(), "end-of-file before header (truncated file)");
+      else
+        err(charno(), "end-of-file before header (empty file)");
+    } else if (is_space(ch)) {
+      if (strict)
+        srr(charno(), "expected 'c' or 'p' at start of line");
+    } else if (ch == 'c') {
+      while ((ch = next_char()) != '\n')
+        if (ch == EOF)
+          err(charno(), "end-of-file in header comment");
+      continue;
+    } else if (ch == 'p')
+      break;
+    else
+      err(charno(), "unexpected character (expected 'p' or 'c')");
+  }
+  int ch = next_char();
+  if (strict) {
+    if (ch != ' ')
+      srr(charno(), "expected %s after 'p'", space_name(' '));
+    ch = next_char();
+  } else {
+    if (ch != ' ' && ch != '\t')
+      err(charno(), "expected %s or %s after 'p'", space_name(' '),
+          space_name('\t'));
+    do
+      ch = next_char();
+    while (ch == ' ' || ch == '\t');
+  }
+  if (ch != 'c')
+    err(charno(), "expected 'c'");
+  ch = next_char();
+  if (ch != 'n')
+    err(charno(), "expected 'n' after 'c'");
+  ch = next_char();
+  if (ch != 'f')
+    err(charno(), "expected 'f' after 'cn'");
+  ch = next_char();
+  if (strict) {
+    if (ch != ' ')
+      srr(charno(), "expected %s after 'p cnf'", space_name(' '));
+    ch = next_char();
+  } else {
+    if (ch != ' ' && ch != '\t')
+      err(charno(), "expected %s or %s after 'cnf'", space_name(' '),
+          space_name('\t'));
+    do
+      ch = next_char();
+    while (ch == ' ' || ch == '\t');
+  }
+  {
+    if (!is_digit(ch))
+      err(charno(), "expected digit after 'p cnf '");
+    const size_t maximum_variables_limit = INT_MAX;
+    specified_variables = ch - '0';
+    while (is_digit(ch = next_char())) {
+      if (strict && !specified_variables)
+        srr(charno() - 1, "leading '0' digit in number of variables");
+      if (maximum_variables_limit / 10 < specified_variables)
+        err(charno(), "maximum variable limit exceeded");
+      specified_variables *= 10;
+      unsigned digit = ch - '0';
+      if (maximum_variables_limit - digit < specified_variables)
+        err(charno(), "maximum variable limit exceeded");
+      specified_variables += digit;
+    }
+  }
+  if (strict) {
+    if (ch != ' ')
+      srr(charno(), "expected %s after 'p cnf %zu'", space_name(' '),
+          specified_variables);
+    ch = next_char();
+  } else {
+    if (ch != ' ' && ch != '\t')
+      err(charno(), "expected %s or %s after 'cnf %zu'", space_name(' '),
+          space_name('\t'), specified_variables);
+    do
+      ch = next_char();
+    while (ch == ' ' || ch == '\t');
+  }
+  {
+    if (!is_digit(ch))
+      err(charno(), "expected digit after 'p cnf %zu '", specified_variables);
+    const size_t maximum_clauses_limit = ~(size_t)0;
+    specified_clauses = ch - '0';
+    while (is_digit(ch = next_char())) {
+      if (strict && !specified_clauses)
+        srr(charno() - 1, "leading '0' digit in number of clauses");
+      if (maximum_clauses_limit / 10 < specified_clauses)
+        err(charno(), "maximum clauses limit exceeded");
+      specified_clauses *= 10;
+      unsigned digit = ch - '0';
+      if (maximum_clauses_limit - digit < specified_clauses)
+        err(charno(), "maximum clauses limit exceeded");
+      specified_clauses += digit;
+    }
+    if (ch == EOF) {
+      if (strict)
+        srr(charno(), "end-of-file after 'p cnf %zu %zu'", specified_variables,
+            specified_clauses);
+      else if (specified_clauses)
+        err(charno(), "end-of-file after 'p cnf %zu %zu'", specified_variables,
+            specified_clauses);
+    }
+    if (strict) {
+      if (ch == '\r') {
+        ch = next_char();
+        if (ch != '\n')
+          srr(charno(), "expected %s after %s after 'p cnf %zu %zu'",
+              space_name('\n'), space_name('\r'), specified_variables,
+              specified_clauses);
+      } else if (ch != '\n')
+        srr(charno(), "expected %s after 'p cnf %zu %zu'", space_name(' '),
+            specified_variables, specified_clauses);
+      ch = next_char();
+    } else {
+      if (ch == 'c') {
+        while ((ch = next_char()) != '\n' && ch != EOF)
+          ;
+      } else {
+        if (!is_space(ch) && ch != EOF)
+          err(charno(), "expected %s or %s after 'p cnf %zu %zu'",
+              space_name(' '), space_name('\n'), specified_variables,
+              specified_clauses);
+        while (is_space(ch) && ch != '\n')
+          ch = next_char();
+      }
+      if (ch == EOF && specified_clauses)
+        err(charno(), "end-of-file after 'p cnf %zu %zu'", specified_variables,
+            specified_clauses);
+    }
+  }
+  msg("parsed header 'p cnf %zu %zu'", specified_variables, specified_clauses);
+  return ch;
+}
+
+// Vectorized tokenizer for the common case of the clause section, i.e.,
+// short integers separated by single spaces and new-lines.  The input is
+// classified in windows of 64 bytes into digits, spaces and signs with
+// AVX2 or SSE2 (selected at run-time) or a scalar fallback.  Digit runs
+// are converted with SWAR arithmetic (eight digits at once).  All literals
+// completely contained in a window are handled directly, as long as they
+// can not trigger any diagnostic.  Otherwise, or if a comment starts, the
+// position is updated as if all handled characters had been read by
+// 'next_char' and parsing continues with the scalar parser.
+
+#define WINDOW_SIZE 64
+#define WINDOW_SLACK 8
+
+struct classes {
+  uint64_t digits, spaces, blanks, newlines, signs;
+};
+
+#ifdef __x86_64__
+
+static void classify_sse2(const unsigned char *p, struct classes *c) {
+  memset(c, 0, sizeof *c);
+  for (unsigned i = 0; i != WINDOW_SIZE; i += 16) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+    const __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+    const __m128i newlines = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    const __m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                        _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    const __m128i returns = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+    const __m128i spaces =
+        _mm_or_si128(_mm_or_si128(blanks, returns), newlines);
+    const __m128i signs = _mm_cmpeq_epi8(v, _mm_set1_epi8('-'));
+    c->digits |= (uint64_t)(uint16_t)_mm_movemask_epi8(digits) << i;
+    c->spaces |= (uint64_t)(uint16_t)_mm_movemask_epi8(spaces) << i;
+    c->blanks |= (uint64_t)(uint16_t)_mm_movemask_epi8(blanks) << i;
+    c->newlines |= (uint64_t)(uint16_t)_mm_movemask_epi8(newlines) << i;
+    c->signs |= (uint64_t)(uint16_t)_mm_movemask_epi8(signs) << i;
+  }
+}
+
+__attribute__((target("avx2"))) static void
+classify_avx2(const unsigned char *p, struct classes *c) {
+  memset(c, 0, sizeof *c);
+  for (unsigned i = 0; i != WINDOW_SIZE; i += 32) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    const __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    const __m256i digits =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+    const __m256i newlines = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    const __m256i blanks =
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+    const __m256i returns = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'));
+    const __m256i spaces =
+        _mm256_or_si256(_mm256_or_si256(blanks, returns), newlines);
+    const __m256i signs = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'));
+    c->digits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(digits) << i;
+    c->spaces |= (uint64_t)(uint32_t)_mm256_movemask_epi8(spaces) << i;
+    c->blanks |= (uint64_t)(uint32_t)_mm256_movemask_epi8(blanks) << i;
+    c->newlines |= (uint64_t)(uint32_t)_mm256_movemask_epi8(newlines) << i;
+    c->signs |= (uint64_t)(uint32_t)_mm256_movemask_epi8(signs) << i;
+  }
+}
+
+#else
+
+static void classify_scalar(const unsigned char *p, struct classes *c) {
+  memset(c, 0, sizeof *c);
+  for (unsigned i = 0; i != WINDOW_SIZE; i++) {
+    const uint64_t bit = (uint64_t)1 << i;
+    const int ch = p[i];
+    if (is_digit(ch))
+      c->digits |= bit;
+    else if (is_space(ch)) {
+      c->spaces |= bit;
+      if (ch == '\n')
+        c->newlines |= bit;
+      else if (ch == ' ' || ch == '\t')
+        c->blanks |= bit;
+    } else if (ch == '-')
+      c->signs |= bit;
+  }
+}
+
+#endif
+
+static void (*classify)(const unsigned char *, struct classes *);
+
+static void select_classifier(void) {
+#ifdef __x86_64__
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    vrb("using AVX2 tokenizer");
+    classify = classify_avx2;
+  } else {
+    vrb("using SSE2 tokenizer");
+    classify = classify_sse2;
+  }
+#else
+  vrb("using scalar tokenizer");
+  classify = classify_scalar;
+#endif
+}
+
+// Mask of all bits at or above position 'i' (for 'i <= 64').
+
+static uint64_t above(unsigned i) { return i < 64 ? ~(uint64_t)0 << i : 0; }
+
+// Converts 'n' digits (from one to eight) starting at 'p'.  Reads eight
+// bytes though, which is covered by the window slack.
+
+static unsigned convert_digits(const unsigned char *p, unsigned n) {
+  assert(1 <= n && n <= 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t v;
+  memcpy(&v, p, sizeof v);
+  if (n < 8)
+    v = (v << (8 * (8 - n))) | (UINT64_C(0x3030303030303030) >> (8 * n));
+  v = ((v & UINT64_C(0x0F0F0F0F0F0F0F0F)) * 2561) >> 8;
+  v = ((v & UINT64_C(0x00FF00FF00FF00FF)) * 6553601) >> 16;
+  return ((v & UINT64_C(0x0000FFFF0000FFFF)) * UINT64_C(42949672960001)) >>
+         32;
+#else
+  unsigned res = 0;
+  for (const unsigned char *end = p + n; p != end; p++)
+    res = 10 * res + (*p - '0');
+  return res;
+#endif
+}
+
+// Adds a parsed literal to the current clause or finishes the clause at a
+// terminating zero (shared by the scalar and the vectorized tokenizer).
+
+static void parsed_literal(int lit, size_t clause_lineno,
+                           size_t clause_column) {
+  if (lit) {
+    if (tokenizing)
+      emit_literal(lit);
+    else
+      push_literal(lit);
+    if (abs(lit) > maximum_dimacs_variable)
+      maximum_dimacs_variable = abs(lit);
+  } else {
+    parsed_clauses++;
+    if (tokenizing)
+      emit_clause(clause_lineno, clause_column);
+    else {
+      store_clause(clause_lineno, clause_column, parsed_clauses);
+      clear_literals();
+    }
+  }
+}
+
+// Tokenize starting at the already read character at 'p' and return the
+// first character not handled, which is 'p' if nothing was handled.
+
+static const unsigned char *tokenize_fast(const unsigned char *p,
+                                          const unsigned char *end,
+                                          int *last_lit, size_t *clause_lineno,
+                                          size_t *clause_column) {
+  const unsigned char *q = p, *line = p;
+  size_t line_column = column_of(charno()), lines = 0;
+  const size_t lineno = current_line();
+  unsigned i = 0, from = 0;
+  while (end - q >= WINDOW_SIZE + WINDOW_SLACK) {
+    struct classes c;
+    classify(q, &c);
+    bool stop = false;
+    for (i = from = 0; !stop;) {
+      unsigned start = i;
+      if (!strict) {
+        const uint64_t tokens = ~c.spaces & above(i);
+        if (!tokens) {
+          i = WINDOW_SIZE;
+          break;
+        }
+        start = __builtin_ctzll(tokens);
+      } else if (i == WINDOW_SIZE || (c.spaces & ((uint64_t)1 << i)))
+        break;
+      const uint64_t after = c.spaces & above(start + 1);
+      if (!after) {
+        i = start;
+        break;
+      }
+      const unsigned separator = __builtin_ctzll(after);
+      const bool negative = c.signs & ((uint64_t)1 << start);
+      const unsigned first = start + negative, n = separator - first;
+      const uint64_t range = above(first) & ~above(separator);
+      const unsigned char *digits = q + first;
+      i = start, stop = true;
+      if (!n || n > 10 || (c.digits & range) != range)
+        break;
+      if (strict && ((n > 1 && *digits == '0') ||
+                     (negative && *digits == '0') ||
+                     parsed_clauses == specified_clauses))
+        break;
+      uint64_t idx;
+      if (n <= 8)
+        idx = convert_digits(digits, n);
+      else {
+        idx = convert_digits(digits, 8);
+        for (unsigned j = 8; j != n; j++)
+          idx = 10 * idx + (digits[j] - '0');
+      }
+      if (idx > INT_MAX || idx > specified_variables)
+        break;
+      if (strict && q[separator] != (idx ? ' ' : '\n'))
+        break;
+      stop = false;
+      const uint64_t newlines = c.newlines & above(from) & ~above(start);
+      if (newlines) {
+        lines += __builtin_popcountll(newlines);
+        line = q + (63 - __builtin_clzll(newlines)) + 1;
+        line_column = 1;
+      }
+      from = start;
+      const int lit = negative ? -(int)idx : (int)idx;
+      if (!*last_lit) {
+        *clause_lineno = lineno + lines;
+        *clause_column = (q + start - line) + line_column;
+      }
+      parsed_literal(lit, *clause_lineno, *clause_column);
+      *last_lit = lit;
+      i = separator + strict;
+    }
+    const uint64_t newlines = c.newlines & above(from) & ~above(i);
+    if (newlines) {
+      lines += __builtin_popcountll(newlines);
+      line = q + (63 - __builtin_clzll(newlines)) + 1;
+      line_column = 1;
+    }
+    q += i;
+    if (stop || !i)
+      break;
+  }
+  skip_counted(p, q, lines, line);
+  return q;
+}
+
+// Parses the clauses starting with the character 'ch'.  In model-first
+// mode clauses are checked against the already parsed model as soon as
+// they are complete instead of being stored.  In the tokenizer thread of
+// the pipeline they are handed over to the consumer instead.
+
+static void parse_clauses(int ch) {
+  {
+    size_t variables_specified_exceeded = 0;
+    size_t clause_lineno = 0;
+    size_t clause_column = 0;
+    int last_lit = 0;
+
+    if (parse_clauses_in_parallel(ch))
+      ch = next_char();
+
+    for (;;) {
+
+      size_t token = charno();
+
+      if (ch == EOF) {
+      PARSED_END_OF_FILE:
+        if (last_lit)
+          err(charno(), "terminating zero '0' missing in last clause");
+
+        if (parsed_clauses < specified_clauses) {
+          const size_t missing_clauses = specified_clauses - parsed_clauses;
+          if (strict) {
+            if (missing_clauses == 1)
+              srr(charno(), "one clause missing (parsed %zu but %zu specified)",
+                  parsed_clauses, specified_clauses);
+            else
+              srr(charno(),
+                  "%zu clauses missing (parsed %zu but %zu specified)",
+                  missing_clauses, parsed_clauses, specified_clauses);
+          } else {
+            if (missing_clauses == 1)
+              wrn("one clause missing (parsed %zu but %zu specified)",
+                  parsed_clauses, specified_clauses);
+            else
+              wrn("%zu clauses missing (parsed %zu but %zu specified)",
+                  missing_clauses, parsed_clauses, specified_clauses);
+          }
+        } else if (parsed_clauses > specified_clauses) {
+          assert(!strict);
+          const size_t more_clauses_than_specified =
+              parsed_clauses - specified_clauses;
+          if (more_clauses_than_specified == 1)
+            wrn("one clause more than specified "
+                "(parsed %zu but %zu specified)",
+                parsed_clauses, specified_clauses);
+          else
+            wrn("%zu more clauses than specified "
+                "(parsed %zu but %zu specified)",
+                more_clauses_than_specified, parsed_clauses, specified_clauses);
+        }
+
+        if (variables_specified_exceeded)
+          wrn("parsed %zu literals exceeding specified maximum variable '%zu' "
+              "(maximum parsed variable index '%d')",
+              variables_specified_exceeded, specified_variables,
+              maximum_dimacs_variable);
+
+        break;
+      }
+
+      if (is_space(ch)) {
+        if (strict)
+          srr(charno(), "unexpected %s (expected literal)", space_name(ch));
+        ch = next_char();
+        continue;
+      }
+
+      if (ch == 'c') {
+        if (strict)
+          srr(charno(), "unexpected comment 'c' (after 'p cnf' header)");
+        while ((ch = next_char()) != '\n')
+          if (ch == EOF) {
+            if (strict)
+              err(charno(), "end-of-file in comment");
+            else {
+              wrr(charno(), "end-of-file in comment");
+              goto PARSED_END_OF_FILE;
+            }
+          }
+        ch = next_char();
+        continue;
+      }
+
+      if (buffer.end - buffer.pos >= WINDOW_SIZE + WINDOW_SLACK) {
+        const unsigned char *p = buffer.pos - 1;
+        const unsigned char *q = tokenize_fast(
+            p, buffer.end, &last_lit, &clause_lineno, &clause_column);
+        if (q != p) {
+          buffer.pos = (unsigned char *)q;
+          ch = next_char();
+          continue;
+        }
+      }
+
+      if (!last_lit) {
+        clause_column = column_of(charno());
+        clause_lineno = current_line();
+      }
+
+      int sign = 1;
+      if (ch == '-') {
+        ch = next_char();
+        if (strict && ch == '0')
+          srr(charno(), "invalid '0' after '-'");
+        if (!is_digit(ch))
+          err(charno(), "expected digit after '-'");
+        sign = -1;
+      } else if (!is_digit(ch))
+        err(charno(), "expected integer literal (digit or sign)");
+
+      const size_t maximum_variable_index = INT_MAX;
+      size_t idx = ch - '0';
+      while (is_digit(ch = next_char())) {
+        if (strict && !idx)
+          srr(charno() - 1, "leading '0' digit in literal");
+        if (maximum_variable_index / 10 < idx)
+          err(charno(), "literal exceeds maximum variable limit");
+        idx *= 10;
+        const unsigned digit = ch - '0';
+        if (maximum_variable_index - digit < idx)
+          err(charno(), "literal exceeds maximum variable limit");
+        idx += digit;
+      }
+
+      const int lit = sign * (int)idx;
+      assert(abs(lit) <= maximum_variable_index);
+
+      if (!is_space(ch) && ch != 'c')
+        err(charno(), "unexpected character after literal '%d'", lit);
+
+      if (strict && specified_clauses == parsed_clauses)
+        srr(token,
+            "too many clauses "
+            "(start of clause %zu but only %zu specified)",
+            parsed_clauses + 1, specified_clauses);
+
+      if (idx > specified_variables) {
+        if (strict)
+          srr(token, "literal '%d' exceeds specified maximum variable '%zu'",
+              lit, specified_variables);
+        else {
+          if (!variables_specified_exceeded)
+            wrr(token, "literal '%d' exceeds specified maximum variable '%zu'",
+                lit, specified_variables);
+          else if (variables_specified_exceeded == 1)
+            wrr(token,
+                "another literal '%d' exceeds specified maximum variable '%zu' "
+                "(will stop warning about additional ones)",
+                lit, specified_variables);
+          variables_specified_exceeded++;
+        }
+      }
+
+      if (strict && idx && ch != ' ')
+        srr(charno(), "expected %s after literal '%d'", space_name(' '), lit);
+
+      if (strict && !idx) {
+        if (ch == '\r') {
+          ch = next_char();
+          if (ch != '\n')
+            srr(charno(),
+                "expected %s after carriage-return after terminating zero '0'",
+                space_name('\n'));
+        } else if (ch != '\n')
+          srr(charno(), "expected %s after terminating zero '0'",
+              space_name('\n'));
+      }
+
+      if (strict && sign < 0 && !lit)
+        srr(token, "negative zero literal '-0'");
+
+      parsed_literal(lit, clause_lineno, clause_column);
+      last_lit = lit;
+
+      if (strict) {
+        assert((lit && ch == ' ') || (!lit && ch == '\n'));
+        ch = next_char();
+      }
+    }
+  }
+}
+
+static void *tokenize_clauses(void *dummy) {
+  (void)dummy;
+  tokenizing = true;
+  parse_clauses(next_char());
+  flush_batch(true);
+  return 0;
+}
+
+static void parse_clauses_pipelined(int ch) {
+  if (ch == EOF) {
+    parse_clauses(ch);
+    return;
+  }
+  for (unsigned i = 0; i != RING_SIZE; i++) {
+    struct batch *batch = pipeline.batches + i;
+    batch->literals = malloc(BATCH_SIZE * sizeof *batch->literals);
+    batch->positions = malloc(BATCH_SIZE * sizeof *batch->positions);
+    if (!batch->literals || !batch->positions)
+      fatal("out-of-memory allocating pipeline batches");
+  }
+  // The tokenizer reads 'ch' again.
+  assert(buffer.pos[-1] == ch);
+  buffer.pos--;
+  if (parallel.count) {
+    // The part read by the parser is released by the reader thread.
+    struct block *block = pipeline.blocks;
+    const size_t bytes = buffer.end - buffer.pos;
+    enlarge_block(block, bytes);
+    memcpy(block->storage, buffer.pos, bytes);
+    block->begin = block->storage;
+    block->end = block->storage + bytes;
+    block->error = 0;
+    produced_slot(&pipeline.input);
+    count_lines_to(charno());
+    buffer_offset = charno();
+    buffer.begin = buffer.pos = buffer.end = 0;
+  }
+  pipeline.mapped = buffer.end;
+  vrb("parsing clauses in pipeline of reader, tokenizer and consumer thread");
+  size_t clauses = parsed_clauses;
+  const double start = wall_clock_time();
+  if (pthread_create(&pipeline.reader, 0, read_blocks, 0) ||
+      pthread_create(&pipeline.tokenizer, 0, tokenize_clauses, 0))
+    fatal("failed to create pipeline thread");
+  bool last;
+  do {
+    const size_t slot =
+        consume_slot(&pipeline.output, &pipeline.consumer_stalled);
+    const struct batch *batch = pipeline.batches + slot;
+    const struct position *position = batch->positions;
+    for (const int *p = batch->literals, *end = p + batch->size; p != end;
+         p++)
+      if (*p)
+        push_literal(*p);
+      else {
+        store_clause(position->lineno, position->column, ++clauses);
+        clear_literals();
+        position++;
+      }
+    last = batch->last;
+    consumed_slot(&pipeline.output);
+  } while (!last);
+  pthread_join(pipeline.tokenizer, 0);
+  pthread_join(pipeline.reader, 0);
+  const double total = wall_clock_time() - start;
+  vrb("reader stalled %.2f seconds (%.0f%%) waiting for tokenizer",
+      pipeline.reader_stalled, percent(pipeline.reader_stalled, total));
+  vrb("tokenizer stalled %.2f seconds (%.0f%%) waiting for reader",
+      pipeline.input_stalled, percent(pipeline.input_stalled, total));
+  vrb("tokenizer stalled %.2f seconds (%.0f%%) waiting for consumer",
+      pipeline.output_stalled, percent(pipeline.output_stalled, total));
+  vrb("consumer stalled %.2f seconds (%.0f%%) waiting for tokenizer",
+      pipeline.consumer_stalled, percent(pipeline.consumer_stalled, total));
+  decompression_time += pipeline.input_stalled;
+  for (unsigned i = 0; i != RING_SIZE; i++) {
+    free(pipeline.blocks[i].storage);
+    free(pipeline.batches[i].literals);
+    free(pipeline.batches[i].positions);
+  }
+  memset(&pipeline, 0, sizeof pipeline);
+}
+
+// Parses the clauses after the header starting with the character 'ch'.
+
+// Reserve the clause kinds for the number of clauses in the header if
+// this is plausible, i.e., for memory mapped plain files if each clause
+// fits into two characters of the rest of the file and otherwise up to
+// a limit.  Everything else is enlarged on demand.
+
+static void init_clauses(void) {
+  size_t clauses = specified_clauses;
+  if (format == PLAIN && mapped.begin) {
+    if (clauses > (size_t)(mapped.end - buffer.pos) / 2)
+      clauses = 0;
+  } else if (clauses > MAXIMUM_RESERVED_CLAUSES)
+    clauses = 0;
+  if (clauses / 4 >= MINIMUM_STORE_SIZE)
+    reserve_kinds(clauses / 4 + 1);
+  push_offset();
+}
+
+static void parse_dimacs_clauses(int ch) {
+  if (!model_first)
+    init_clauses();
+  if (pipelined)
+    parse_clauses_pipelined(ch);
+  else
+    parse_clauses(ch);
+  reset_parsing();
+  msg("parsed %zu clauses with maximum variable index '%d'", parsed_clauses,
+      maximum_dimacs_variable);
+  if (compact)
+    vrb("compacted clauses into %zu bytes (%.2f bytes per clause)",
+        (size_t)(compacted.end - compacted.begin),
+        average(compacted.end - compacted.begin, parsed_clauses));
+
+  if ((size_t) maximum_dimacs_variable < specified_variables) {
+    vrb ("maximum parsed variable '%d' smaller than specified variables '%zu'",
+         maximum_dimacs_variable, specified_variables);
+    maximum_dimacs_variable = specified_variables;
+  }
+}
+
+// The position of an unsatisfied clause, which was not stored, is found
+// by parsing the DIMACS file again up to that clause (quietly, since all
+// warnings have already been printed).  There 'store_clause' checks it
+// again and reports it exactly as if its position had been stored.
+
+static void locate_unsatisfied_clause(size_t idx) {
+  if (verbosity > -1)
+    verbosity = -1;
+  parsed_clauses = 0;
+  clear_literals();
+  locating = idx;
+  parse_clauses(parse_dimacs_header());
+  die("DIMACS file '%s' changed while checking", dimacs_path);
+}
+
+// Sets the position and the original literals of the violation which is
+// currently located and continues with the next one without position.
+
+static void located_violation(size_t lineno, size_t column) {
+  struct violation *v = violations.locating;
+  assert(v && v->idx == locating);
+  if (size_literals() != v->size)
+    die("DIMACS file '%s' changed while checking", dimacs_path);
+  if (v->size)
+    memcpy(violations.literals.begin + v->offset, literals.begin,
+           v->size * sizeof *literals.begin);
+  v->lineno = lineno, v->column = column;
+  while (++v != violations.end && v->lineno)
+    ;
+  violations.locating = v;
+  locating = v == violations.end ? SIZE_MAX : v->idx;
+}
+
+// Parses the DIMACS file again (quietly) to find the positions of all
+// recorded violations for which the position is not known yet.
+
+static void locate_violations(void) {
+  struct violation *v = violations.begin;
+  while (v != violations.end && v->lineno)
+    v++;
+  if (v == violations.end)
+    return;
+  if (verbosity > -1)
+    verbosity = -1;
+  parsed_clauses = 0;
+  clear_literals();
+  violations.locating = v;
+  locating = v->idx;
+  parse_clauses(parse_dimacs_header());
+  if (violations.locating != violations.end)
+    die("DIMACS file '%s' changed while checking", dimacs_path);
+}
+
+static void violation_error(const char *, ...)
+    __attribute__((format(printf, 1, 2)));
+
+static void violation_error(const char *fmt, ...) {
+  if (verbosity == INT_MIN)
+    return;
+  fputs("dimocheck: error: ", errors);
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(errors, fmt, ap);
+  va_end(ap);
+  fputc('\n', errors);
+}
+
+// Prints the recorded violations followed by a summary and exits, unless
+// there are no violations at all.
+
+static void report_violations(void) {
+  if (!violations.unsatisfied && !violations.missing)
+    return;
+  locate_violations();
+  for (const struct violation *v = violations.begin; v != violations.end;
+       v++) {
+    const int *begin = violations.literals.begin + v->offset;
+    print_unsatisfied_clause(v->lineno, v->column, v->idx, begin,
+                             begin + v->size);
+  }
+  for (const size_t *p = violations.variables.begin;
+       p != violations.variables.end; p++)
+    violation_error("complete checking mode: "
+                    "value for DIMACS variable '%zu' missing",
+                    *p);
+  if (violations.unsatisfied) {
+    const size_t reported = violations.end - violations.begin;
+    if (violations.unsatisfied == 1)
+      violation_error("one unsatisfied clause (%zu reported)", reported);
+    else
+      violation_error("%zu unsatisfied clauses (%zu reported)",
+                      violations.unsatisfied, reported);
+    for (unsigned i = 0; i != EXACT_SIZES + 64; i++) {
+      const size_t count = violations.sizes[i];
+      if (!count)
+        continue;
+      if (i < EXACT_SIZES) {
+        if (count == 1)
+          violation_error("one unsatisfied clause of size %u", i);
+        else
+          violation_error("%zu unsatisfied clauses of size %u", count, i);
+      } else {
+        const size_t lower = (size_t)1 << (i - EXACT_SIZES + 4);
+        if (count == 1)
+          violation_error("one unsatisfied clause of size %zu to %zu", lower,
+                          2 * lower - 1);
+        else
+          violation_error("%zu unsatisfied clauses of size %zu to %zu",
+                          count, lower, 2 * lower - 1);
+      }
+    }
+  }
+  if (violations.missing) {
+    const size_t reported =
+        violations.variables.end - violations.variables.begin;
+    if (violations.missing == 1)
+      violation_error("one value of a DIMACS variable missing "
+                      "(%zu reported)",
+                      reported);
+    else
+      violation_error("%zu values of DIMACS variables missing "
+                      "(%zu reported)",
+                      violations.missing, reported);
+  }
+  fflush(errors);
+  failed(DIMOCHECK_UNSATISFIED);
+}
+
+// Fast path for the values of 'v' lines using the same vectorized
+// classification and digit conversion as 'tokenize_fast'.  It handles
+// non-zero values which do not exceed the maximum variable and are not
+// assigned yet (or are assigned the same value again in relaxed mode).
+// In relaxed mode it also continues over new-lines followed by 'v' and
+// blanks.  It always stops at a character where 'parse_model' can continue
+// parsing values, i.e., at the start of a value or (relaxed) a new-line.
+
+static const unsigned char *parse_values_fast(const unsigned char *p,
+                                              const unsigned char *end,
+                                              size_t *parsed_values,
+                                              size_t *positive_values,
+                                              size_t *negative_values) {
+  if (verbosity == INT_MAX)
+    return p;
+  const size_t maximum_variable =
+      model_first ? specified_variables : (size_t)maximum_dimacs_variable;
+  const unsigned char *q = p;
+  while (end - q >= WINDOW_SIZE + WINDOW_SLACK) {
+    struct classes c;
+    classify(q, &c);
+    unsigned i = 0;
+    for (;;) {
+      const unsigned start = i;
+      if (start == WINDOW_SIZE || (c.spaces & ((uint64_t)1 << start)))
+        break;
+      const uint64_t after = c.spaces & above(start + 1);
+      if (!after)
+        break;
+      const unsigned separator = __builtin_ctzll(after);
+      const bool negative = c.signs & ((uint64_t)1 << start);
+      const unsigned first = start + negative, n = separator - first;
+      const uint64_t range = above(first) & ~above(separator);
+      const unsigned char *digits = q + first;
+      if (!n || n > 10 || (c.digits & range) != range)
+        break;
+      if (strict && n > 1 && *digits == '0')
+        break;
+      uint64_t idx;
+      if (n <= 8)
+        idx = convert_digits(digits, n);
+      else {
+        idx = convert_digits(digits, 8);
+        for (unsigned j = 8; j != n; j++)
+          idx = 10 * idx + (digits[j] - '0');
+      }
+      if (!idx || idx > maximum_variable || idx >= values.size)
+        break;
+      unsigned next;
+      if (strict) {
+        if (q[separator] != ' ')
+          break;
+        next = separator + 1;
+      } else {
+        const uint64_t rest = ~c.spaces & above(separator);
+        if (!rest)
+          break;
+        next = __builtin_ctzll(rest);
+        const uint64_t newlines =
+            c.newlines & above(separator) & ~above(next);
+        if (newlines) {
+          const unsigned newline = __builtin_ctzll(newlines);
+          if (newline + 1 == next && q[next] == 'v' &&
+              next + 1 < WINDOW_SIZE &&
+              (c.blanks & ((uint64_t)1 << (next + 1)))) {
+            const uint64_t nonblanks = ~c.blanks & above(next + 1);
+            if (!nonblanks)
+              break;
+            next = __builtin_ctzll(nonblanks);
+          } else
+            next = newline;
+        }
+      }
+      const int lit = negative ? -(int)idx : (int)idx;
+      const int old_value = value_of(idx);
+      if (old_value && (strict || old_value != lit))
+        break;
+      assign(lit);
+      *parsed_values += 1;
+      *positive_values += !old_value & (lit > 0);
+      *negative_values += !old_value & (lit < 0);
+      if (idx > (size_t)maximum_model_variable)
+        maximum_model_variable = idx;
+      i = next;
+    }
+    q += i;
+    if (!i)
+      break;
+  }
+  return q;
+}
+
+// In model-first mode the model is parsed after the DIMACS header but
+// before the clauses.  Thus the maximum DIMACS variable is not known yet
+// while parsing the model.  Values exceeding the number of variables
+// specified in the header are recorded with their position instead and
+// only reported at the end, if they exceed the maximum variable index of
+// the formula, exactly as 'parse_model' would have reported them.
+
+STATE struct {
+  struct exceeding_value {
+    size_t lineno, column;
+    int lit;
+  } *begin, *end, *allocated;
+} exceeding_values;
+
+static void defer_exceeding_value(size_t token, int lit) {
+  if (exceeding_values.end == exceeding_values.allocated) {
+    const size_t old_capacity =
+        exceeding_values.allocated - exceeding_values.begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 1;
+    void *new_begin = realloc(exceeding_values.begin,
+                              new_capacity * sizeof *exceeding_values.begin);
+    if (!new_begin)
+      fatal("out-of-memory reallocating exceeding values");
+    exceeding_values.begin = new_begin;
+    exceeding_values.end = exceeding_values.begin + old_capacity;
+    exceeding_values.allocated = exceeding_values.begin + new_capacity;
+  }
+  exceeding_values.end->column = column_of(token);
+  exceeding_values.end->lineno = current_line();
+  exceeding_values.end->lit = lit;
+  exceeding_values.end++;
+}
+
+// Values are kept dense as long as the variable index is at most twice
+// the number of variables needed for the formula plus the number of values
+// parsed so far, and otherwise are put into the sparse value table.
+
+static bool dense_value(size_t idx, size_t parsed_values) {
+  const size_t needed =
+      model_first ? specified_variables : (size_t)maximum_dimacs_variable;
+  return idx / 2 <= needed + parsed_values;
+}
+
+static void parse_model(void) {
+
+  tailing = follow;
+  init_parsing(model_path);
+  msg("parsing model '%s'", path);
+  if (strict) {
+    assert(strict_option);
+    msg("parsing in strict mode (due to '%s')", strict_option);
+  } else
+    msg("parsing in relaxed mode (without '--strict' nor '--pedantic')");
+
+  size_t parsed_values = 0, positive_values = 0, negative_values = 0;
+
+  // Allocate all values up-front if the model file is large enough to
+  // hold values for all variables (each value needs at least two bytes).
+  {
+    const size_t maximum_variable =
+        model_first ? specified_variables : (size_t)maximum_dimacs_variable;
+    if (maximum_variable < (size_t)(mapped.end - mapped.begin) / 2)
+      fit_values(maximum_variable);
+  }
+
+  bool reported_missing_status_line = false;
+  bool reported_found_status_line = false;
+  size_t dimacs_variable_exceeded = 0;
+  size_t first_vline_section = 0;
+  size_t first_status_line = 0;
+  size_t value_sections = 0;
+  size_t status_lines = 0;
+
+  int ch = next_char();
+  for (;;) {
+
+    if (ch == EOF)
+      break;
+
+    if (is_space(ch)) {
+      if (strict)
+        srr(charno(), "unexpected %s (expected 'c' or 's')", space_name(ch));
+      ch = next_char();
+      continue;
+    }
+
+    size_t token = charno();
+    if (ch == 'c') {
+      while ((ch = next_char()) != '\n')
+        if (ch == EOF)
+          err(charno(), "end-of-file in comment");
+      ch = next_char();
+
+      continue; // With outer 'for' loop.
+    }
+
+    if (ch == 's') {
+      const size_t start_of_status_line = current_line();
+      ch = next_char();
+      if (strict) {
+        if (ch != ' ')
+          srr(charno(), "expected %s after 's'", space_name(' '));
+        ch = next_char();
+      } else {
+        if (ch != ' ' && ch != '\t')
+          srr(charno(), "expected %s or %s after 's'", space_name(' '),
+              space_name('\t'));
+        do
+          ch = next_char();
+        while (ch == ' ' || ch == '\t');
+      }
+      for (const char *p = "SATISFIABLE"; *p; p++)
+        if (ch != *p)
+          err(token, "invalid status line (expected 's SATISFIABLE')");
+        else
+          ch = next_char();
+      if (strict) {
+        if (ch == '\r') {
+          ch = next_char();
+          if (ch != '\n')
+            srr(charno(), "expected %s after %s after 's SATISFIABLE'",
+                space_name('\n'), space_name('\r'));
+        }
+        if (ch != '\n')
+          srr(charno(), "expected %s after 's SATISFIABLE'", space_name('\n'));
+        if (strict && status_lines)
+          srr(token, "second 's SATISFIABLE' line (first at line %zu)",
+              first_status_line);
+      } else {
+        while (ch != EOF && ch != '\n' && is_space(ch))
+          ch = next_char();
+      }
+      if (!reported_found_status_line) {
+        msg("found 's SATISFIABLE' status line");
+        reported_found_status_line = true;
+      }
+      if (!status_lines++)
+        first_status_line = start_of_status_line;
+
+      if (ch == '\n')
+        ch = next_char();
+      continue; // With outer 'for' loop.
+    }
+
+    if (ch == 'v') {
+
+      if (!status_lines) {
+        if (strict)
+          srr(charno(), "'v' line without 's SATISFIABLE' status line");
+        else if (!reported_missing_status_line) {
+          wrr(charno(), "'v' line without 's SATISFIABLE' status line");
+          reported_missing_status_line = true;
+        }
+      }
+
+      if (value_sections++) {
+        if (strict)
+          srr(charno(), "second 'v' line (first at line %zu)",
+              first_vline_section);
+        else if (value_sections == 2)
+          wrr(charno(), "second 'v' line section (first at line %zu)",
+              first_vline_section);
+        else if (value_sections == 3)
+          wrr(charno(),
+              "third 'v' line section (will stop warning about more)");
+      }
+
+      if (!first_vline_section)
+        first_vline_section = current_line();
+
+      for (;;) { // Ranges over all 'v' lines of one section.
+
+        ch = next_char();
+        if (strict) {
+          if (ch != ' ')
+            srr(charno(), "expected %s after 'v'", space_name(' '));
+          ch = next_char();
+        } else {
+        PARSE_SPACE_AFTER_V:
+          if (ch != ' ' && ch != '\t')
+            err(charno(), "expected %s or %s after 'v'", space_name(' '),
+                space_name('\t'));
+          while (ch == ' ' || ch == '\t')
+            ch = next_char();
+        }
+
+        for (;;) { // Ranges over values in one 'v' line.
+
+          if (ch == EOF)
+            err(charno(), "end-of-file in 'v' line");
+
+          if (!strict && ch == '\n') {
+          CONTINUE_IN_VLINE_AFTER_NEW_LINE:
+            ch = next_char();
+            if (ch != 'v')
+              err(charno(), "expected 'v' as first character");
+            ch = next_char();
+            goto PARSE_SPACE_AFTER_V;
+          }
+
+          token = charno();
+
+          if (buffer.end - buffer.pos >= WINDOW_SIZE + WINDOW_SLACK) {
+            const unsigned char *p = buffer.pos - 1;
+            const unsigned char *q =
+                parse_values_fast(p, buffer.end, &parsed_values,
+                                  &positive_values, &negative_values);
+            if (q != p) {
+              buffer.pos = (unsigned char *)q;
+              ch = next_char();
+              continue;
+            }
+          }
+
+          int sign = 1;
+          if (ch == '-') {
+            ch = next_char();
+            if (strict && ch == '0')
+              srr(charno(), "invalid '0' after '-'");
+            if (!is_digit(ch))
+              err(charno(), "expected digit after '-'");
+            sign = -1;
+          } else if (!is_digit(ch))
+            err(charno(), "expected integer literal (digit or sign)");
+
+          const size_t maximum_variable_index = INT_MAX;
+          size_t idx = ch - '0';
+          while (is_digit(ch = next_char())) {
+            if (strict && !idx)
+              srr(charno() - 1, "leading '0' digit in literal");
+            if (maximum_variable_index / 10 < idx)
+              err(charno(), "literal exceeds maximum variable limit");
+            idx *= 10;
+            const unsigned digit = ch - '0';
+            if (maximum_variable_index - digit < idx)
+              err(charno(), "literal exceeds maximum variable limit");
+            idx += digit;
+          }
+
+          const int lit = sign * (int)idx;
+          assert(abs(lit) <= maximum_variable_index);
+
+          if (model_first && idx > specified_variables)
+            defer_exceeding_value(token, lit);
+          else if (!model_first && idx > (size_t)maximum_dimacs_variable) {
+            if (strict)
+              srr(token, "literal '%d' exceeds maximum DIMACS variable '%d'",
+                  lit, maximum_dimacs_variable);
+            else if (!dimacs_variable_exceeded)
+              wrr(token, "literal '%d' exceeds maximum DIMACS variable '%d'",
+                  lit, maximum_dimacs_variable);
+            else if (dimacs_variable_exceeded == 1)
+              wrr(token,
+                  "another literal '%d' exceeds maximum DIMACS variable '%d' "
+                  "(will stop warning about additional ones)",
+                  lit, maximum_dimacs_variable);
+            dimacs_variable_exceeded++;
+          }
+
+          if (verbosity == INT_MAX) {
+            if (lit)
+              printf(PREFIX "parsed value literal '%d'\n", lit);
+            else
+              printf(PREFIX "parsed terminating zero '0'\n");
+            fflush(stdout);
+          }
+
+          if (idx) {
+            parsed_values++;
+            if (idx > (size_t)maximum_model_variable)
+              maximum_model_variable = idx;
+          }
+
+          if (idx >= values.size && dense_value(idx, parsed_values))
+            fit_values(idx);
+
+          assert(idx <= (size_t)INT_MAX);
+          const int old_value = value_of(idx);
+          const int new_value = lit;
+
+          if (old_value && old_value != new_value)
+            err(token, "old value '%d' overwritten by new value '%d'",
+                old_value, new_value);
+
+          if (strict && old_value) {
+            assert(old_value == new_value);
+            srr(token, "value '%d' set twice", new_value);
+          }
+
+          if (old_value != new_value) {
+            if (new_value < 0)
+              negative_values++;
+            else
+              positive_values++;
+          }
+          if (new_value)
+            assign(new_value);
+
+          if (lit) {
+
+            if (strict) {
+              if (ch != ' ')
+                srr(charno(), "expected %s after '%d'", space_name(' '), lit);
+
+              ch = next_char();
+
+            } else {
+              if (!is_space(ch))
+                err(charno(), "expected white-space after '%d'", lit);
+              while (ch != '\n' && is_space(ch))
+                ch = next_char();
+              if (ch == '\n')
+                goto CONTINUE_IN_VLINE_AFTER_NEW_LINE;
+            }
+
+          } else {
+
+            tailing = false;
+
+            if (strict) {
+              if (ch == '\r') {
+                ch = next_char();
+                if (ch != '\n')
+                  srr(charno(), "expected %s after %s after '0'",
+                      space_name('\n'), space_name('\r'));
+              } else if (ch != '\n')
+                srr(charno(), "expected %s after '0'", space_name('\n'));
+
+            } else {
+              while (ch != '\n' && is_space(ch))
+                ch = next_char();
+              if (ch == 'c') {
+                while ((ch = next_char()) != '\n')
+                  if (ch == EOF) {
+                    wrr(charno(), "end-of-file in comment after '0'");
+                    break;
+                  }
+              } else if (ch != EOF && ch != '\n')
+                err(charno(), "expected %s after '0'", space_name('\n'));
+            }
+
+            if (ch != EOF) {
+              assert(ch == '\n');
+              ch = next_char();
+            }
+            goto CONTINUE_WITH_OUTER_LOOP;
+          }
+
+        } // End of 'for' loop over all all values in one 'v' line.
+
+      } // End of 'for' loop over all 'v' lines of one section.
+
+      continue; // With outer loop (new 'c', 's, or 'v' lines).
+    }
+
+    err(charno(), "expected 'c', 's' or 'v' as first character");
+
+  CONTINUE_WITH_OUTER_LOOP:;
+  } // End of outer 'for' loop over 'c', 's' and 'v' parts.
+
+  reset_parsing();
+  size_t total_set = positive_values + negative_values;
+  msg("parsed %zu and set %zu values of variables with maximum index '%d'",
+      parsed_values, total_set, maximum_model_variable);
+  if (sparse.count)
+    vrb("kept %zu values of variables beyond '%zu' in sparse table",
+        sparse.count, values.size ? values.size - 1 : 0);
+  msg("set %zu positive %.2f%% and %zu negative values %.2f%%", positive_values,
+      percent(positive_values, total_set), negative_values,
+      percent(negative_values, total_set));
+}
+
+// The following functions return the index (starting at zero) of the
+// first unsatisfied clause of one kind among the clauses with index from
+// 'from' up to (but excluding) 'to' or 'SIZE_MAX' if all are satisfied.
+
+static size_t unsatisfied_units_scalar(size_t from, size_t to) {
+  const int *const begin = units.begin;
+  for (const int *p = begin + from, *end = begin + to; p != end; p++)
+    if (falsified(p[0]))
+      return p - begin;
+  return SIZE_MAX;
+}
+
+static size_t unsatisfied_binaries_scalar(size_t from, size_t to) {
+  const int *const begin = binaries.begin;
+  for (const int *p = begin + 2 * from, *end = begin + 2 * to; p != end;
+       p += 2)
+    if (falsified(p[0]) && falsified(p[1]))
+      return (p - begin) / 2;
+  return SIZE_MAX;
+}
+
+static size_t unsatisfied_ternaries_scalar(size_t from, size_t to) {
+  const int *const begin = ternaries.begin;
+  for (const int *p = begin + 3 * from, *end = begin + 3 * to; p != end;
+       p += 3)
+    if (falsified(p[0]) && falsified(p[1]) && falsified(p[2]))
+      return (p - begin) / 3;
+  return SIZE_MAX;
+}
+
+static size_t unsatisfied_general_scalar(size_t from, size_t to) {
+  for (const size_t *p = offsets.begin + from, *end = offsets.begin + to;
+       p != end; p++) {
+    const int *q = arena.begin + p[0], *end = arena.begin + p[1];
+    while (q != end && falsified(*q))
+      q++;
+    if (q == end)
+      return p - offsets.begin;
+  }
+  return SIZE_MAX;
+}
+
+// Decoding starts at the check-point of the block of 'from', which thus
+// has to be a multiple of 'CHECK_BLOCK_SIZE'.
+
+static size_t unsatisfied_compacted(size_t from, size_t to) {
+  assert(!(from % CHECK_BLOCK_SIZE));
+  const unsigned char *p =
+      compacted.begin + checkpoints.begin[from / CHECK_BLOCK_SIZE];
+  for (size_t idx = from; idx != to; idx++) {
+    size_t size = decode_varint(&p);
+    unsigned variable = 0;
+    bool satisfied = false;
+    while (size--) {
+      const unsigned code = decode_varint(&p);
+      variable += code >> 1;
+      const int lit = (code & 1) ? -(int)variable : (int)variable;
+      satisfied |= !falsified(lit);
+    }
+    if (!satisfied)
+      return idx;
+  }
+  return SIZE_MAX;
+}
+
+// Decodes the literals of the compacted clause with the given index (in
+// sorted order) into 'literals'.
+
+static void decode_compacted(size_t idx) {
+  const unsigned char *p = compacted.begin;
+  for (size_t i = 0;; i++) {
+    size_t size = decode_varint(&p);
+    unsigned variable = 0;
+    while (size--) {
+      const unsigned code = decode_varint(&p);
+      variable += code >> 1;
+      if (i == idx)
+        push_literal((code & 1) ? -(int)variable : (int)variable);
+    }
+    if (i == idx)
+      return;
+  }
+}
+
+// Decodes the next compacted clause at 'p' into 'literals'.
+
+static const unsigned char *decode_next_compacted(const unsigned char *p) {
+  size_t size = decode_varint(&p);
+  unsigned variable = 0;
+  while (size--) {
+    const unsigned code = decode_varint(&p);
+    variable += code >> 1;
+    push_literal((code & 1) ? -(int)variable : (int)variable);
+  }
+  return p;
+}
+
+#ifdef __x86_64__
+
+// The AVX2 evaluator gathers the values of eight literals at once from the
+// value table (viewed as array of 32-bit words) and only falls back to the
+// scalar evaluator for the remaining clauses of a range.  It requires that
+// there are no sparse values.  Short clauses are evaluated eight clauses at
+// once and long clauses eight literals at once.
+
+// Returns a vector with one in each lane for which the literal in 'lits'
+// is assigned to true and zero otherwise, also for lanes not in 'valid'.
+// The bit index of a literal is computed as in 'literal_bit' and 'last' is
+// the last bit index covered by the value table.
+
+__attribute__((target("avx2"))) static __m256i
+true_literals_avx2(__m256i lits, __m256i valid, __m256i last) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bits = _mm256_add_epi32(
+      _mm256_xor_si256(_mm256_add_epi32(lits, lits),
+                       _mm256_srai_epi32(lits, 31)),
+      one);
+  const __m256i covered = _mm256_and_si256(
+      valid, _mm256_cmpeq_epi32(_mm256_min_epu32(bits, last), bits));
+  const __m256i words = _mm256_mask_i32gather_epi32(
+      _mm256_setzero_si256(), (const int *)values.begin,
+      _mm256_srli_epi32(bits, 5), covered, 4);
+  const __m256i shifts = _mm256_and_si256(bits, _mm256_set1_epi32(31));
+  return _mm256_and_si256(_mm256_srlv_epi32(words, shifts), one);
+}
+
+__attribute__((target("avx2"))) static __m256i last_bit_avx2(void) {
+  return _mm256_set1_epi32((int)(unsigned)(2 * values.size - 1));
+}
+
+// Bit mask of the lanes which are zero.
+
+__attribute__((target("avx2"))) static unsigned zero_lanes_avx2(__m256i v) {
+  const __m256i zero = _mm256_cmpeq_epi32(v, _mm256_setzero_si256());
+  return _mm256_movemask_ps(_mm256_castsi256_ps(zero));
+}
+
+__attribute__((target("avx2"))) static size_t
+unsatisfied_units_avx2(size_t from, size_t to) {
+  const int *const begin = units.begin;
+  const __m256i all = _mm256_set1_epi32(-1), last = last_bit_avx2();
+  size_t i = from;
+  for (; to - i >= 8; i += 8) {
+    const __m256i lits = _mm256_loadu_si256((const __m256i *)(begin + i));
+    const unsigned falsified =
+        zero_lanes_avx2(true_literals_avx2(lits, all, last));
+    if (falsified)
+      return i + __builtin_ctz(falsified);
+  }
+  return unsatisfied_units_scalar(i, to);
+}
+
+__attribute__((target("avx2"))) static size_t
+unsatisfied_binaries_avx2(size_t from, size_t to) {
+  const int *const begin = binaries.begin;
+  const __m256i all = _mm256_set1_epi32(-1), last = last_bit_avx2();
+  const __m256i stride = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+  size_t i = from;
+  for (; to - i >= 8; i += 8) {
+    const int *p = begin + 2 * i;
+    const __m256i first = _mm256_i32gather_epi32(p, stride, 4);
+    const __m256i second = _mm256_i32gather_epi32(p + 1, stride, 4);
+    const __m256i satisfied =
+        _mm256_or_si256(true_literals_avx2(first, all, last),
+                        true_literals_avx2(second, all, last));
+    const unsigned falsified = zero_lanes_avx2(satisfied);
+    if (falsified)
+      return i + __builtin_ctz(falsified);
+  }
+  return unsatisfied_binaries_scalar(i, to);
+}
+
+__attribute__((target("avx2"))) static size_t
+unsatisfied_ternaries_avx2(size_t from, size_t to) {
+  const int *const begin = ternaries.begin;
+  const __m256i all = _mm256_set1_epi32(-1), last = last_bit_avx2();
+  const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  size_t i = from;
+  for (; to - i >= 8; i += 8) {
+    const int *p = begin + 3 * i;
+    const __m256i first = _mm256_i32gather_epi32(p, stride, 4);
+    const __m256i second = _mm256_i32gather_epi32(p + 1, stride, 4);
+    const __m256i third = _mm256_i32gather_epi32(p + 2, stride, 4);
+    const __m256i satisfied = _mm256_or_si256(
+        _mm256_or_si256(true_literals_avx2(first, all, last),
+                        true_literals_avx2(second, all, last)),
+        true_literals_avx2(third, all, last));
+    const unsigned falsified = zero_lanes_avx2(satisfied);
+    if (falsified)
+      return i + __builtin_ctz(falsified);
+  }
+  return unsatisfied_ternaries_scalar(i, to);
+}
+
+__attribute__((target("avx2"))) static size_t
+unsatisfied_general_avx2(size_t from, size_t to) {
+  const __m256i all = _mm256_set1_epi32(-1), last = last_bit_avx2();
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (const size_t *p = offsets.begin + from, *end = offsets.begin + to;
+       p != end; p++) {
+    const int *q = arena.begin + p[0], *end = arena.begin + p[1];
+    bool satisfied = q != end && !falsified(*q);
+    while (!satisfied && q < end) {
+      const ptrdiff_t remaining = end - q;
+      const __m256i valid =
+          remaining >= 8
+              ? all
+              : _mm256_cmpgt_epi32(_mm256_set1_epi32(remaining), lanes);
+      const __m256i lits = _mm256_maskload_epi32(q, valid);
+      const __m256i truth = true_literals_avx2(lits, valid, last);
+      satisfied = !_mm256_testz_si256(truth, truth);
+      q += 8;
+    }
+    if (!satisfied)
+      return p - offsets.begin;
+  }
+  return SIZE_MAX;
+}
+
+#endif
+
+STATE bool gathering, scalar;
+
+static void select_evaluator(void) {
+#ifdef __x86_64__
+  if (!scalar && __builtin_cpu_supports("avx2") && values.size &&
+      !sparse.count) {
+    vrb("using AVX2 clause evaluator");
+    gathering = true;
+    return;
+  }
+#endif
+  vrb("using scalar clause evaluator");
+  gathering = false;
+}
+
+static size_t unsatisfied_units(size_t from, size_t to) {
+#ifdef __x86_64__
+  if (gathering)
+    return unsatisfied_units_avx2(from, to);
+#endif
+  return unsatisfied_units_scalar(from, to);
+}
+
+static size_t unsatisfied_binaries(size_t from, size_t to) {
+#ifdef __x86_64__
+  if (gathering)
+    return unsatisfied_binaries_avx2(from, to);
+#endif
+  return unsatisfied_binaries_scalar(from, to);
+}
+
+static size_t unsatisfied_ternaries(size_t from, size_t to) {
+#ifdef __x86_64__
+  if (gathering)
+    return unsatisfied_ternaries_avx2(from, to);
+#endif
+  return unsatisfied_ternaries_scalar(from, to);
+}
+
+static size_t unsatisfied_general(size_t from, size_t to) {
+#ifdef __x86_64__
+  if (gathering)
+    return unsatisfied_general_avx2(from, to);
+#endif
+  return unsatisfied_general_scalar(from, to);
+}
+
+// In compact mode all clauses are compacted and of kind zero.
+
+static size_t count_clauses(unsigned kind) {
+  if (compact)
+    return kind ? 0 : compacted.clauses;
+  switch (kind) {
+  case 1:
+    return size_store(&units);
+  case 2:
+    return size_store(&binaries) / 2;
+  case 3:
+    return size_store(&ternaries) / 3;
+  default:
+    return offsets.end - offsets.begin - 1;
+  }
+}
+
+static size_t unsatisfied_clauses(unsigned kind, size_t from, size_t to) {
+  if (compact)
+    return unsatisfied_compacted(from, to);
+  switch (kind) {
+  case 1:
+    return unsatisfied_units(from, to);
+  case 2:
+    return unsatisfied_binaries(from, to);
+  case 3:
+    return unsatisfied_ternaries(from, to);
+  default:
+    return unsatisfied_general(from, to);
+  }
+}
+
+// With '--check-threads' the clauses of each kind are split into blocks of
+// 'CHECK_BLOCK_SIZE' clauses, which are claimed by the checking threads in
+// order through the atomic counter 'next'.  The first unsatisfied clause
+// of each kind is kept as atomic minimum in 'first'.  Blocks starting after
+// it are skipped.  Since all blocks before it are still checked, the result
+// is exactly the same as checking sequentially.
+
+STATE struct {
+  size_t count[4], blocks[5];
+  atomic_size_t next, first[4];
+} checking;
+
+static void *check_blocks(void *dummy) {
+  (void)dummy;
+  size_t block;
+  while ((block = atomic_fetch_add(&checking.next, 1)) < checking.blocks[4]) {
+    unsigned kind = 0;
+    while (block >= checking.blocks[kind + 1])
+      kind++;
+    const size_t from = (block - checking.blocks[kind]) * CHECK_BLOCK_SIZE;
+    size_t first = atomic_load(&checking.first[kind]);
+    if (from > first)
+      continue;
+    size_t to = from + CHECK_BLOCK_SIZE;
+    if (to > checking.count[kind])
+      to = checking.count[kind];
+    const size_t ordinal = unsatisfied_clauses(kind, from, to);
+    while (ordinal < first &&
+           !atomic_compare_exchange_weak(&checking.first[kind], &first,
+                                         ordinal))
+      ;
+  }
+  return 0;
+}
+
+// Determines the first unsatisfied clause of each kind.
+
+static void find_unsatisfied(size_t *first) {
+  select_evaluator();
+  size_t blocks = 0;
+  for (unsigned kind = 0; kind != 4; kind++) {
+    const size_t count = count_clauses(kind);
+    checking.count[kind] = count;
+    checking.blocks[kind] = blocks;
+    blocks += (count + CHECK_BLOCK_SIZE - 1) / CHECK_BLOCK_SIZE;
   }
-  size_t specified_variables;
-  {
-    if (!is_digit(ch))
-      err(column, "expected digit after 'p cnf '");
-    const size_t maximum_variables_limit = INT_MAX;
-    specified_variables = ch - '0';
-    while (is_digit(ch = next_char())) {
-      if (strict && !specified_variables)
-        srr(column - 1, "leading '0' digit in number of variables");
-      if (maximum_variables_limit / 10 < specified_variables)
-        err(column, "maximum variable limit exceeded");
-      specified_variables *= 10;
-      unsigned digit = ch - '0';
-      if (maximum_variables_limit - digit < specified_variables)
-        err(column, "maximum variable limit exceeded");
-      specified_variables += digit;
+  checking.blocks[4] = blocks;
+  unsigned threads = check_threads;
+  if (threads > blocks)
+    threads = blocks;
+  if (threads < 2) {
+    for (unsigned kind = 0; kind != 4; kind++) {
+      const size_t count = checking.count[kind];
+      first[kind] = count ? unsatisfied_clauses(kind, 0, count) : SIZE_MAX;
     }
+    return;
   }
-  if (strict) {
-    if (ch != ' ')
-      srr(column, "expected %s after 'p cnf %zu'", space_name(' '),
-          specified_variables);
-    ch = next_char();
+  vrb("checking %zu blocks of clauses with %u threads", blocks, threads);
+  atomic_init(&checking.next, 0);
+  for (unsigned kind = 0; kind != 4; kind++)
+    atomic_init(&checking.first[kind], SIZE_MAX);
+  pthread_t *ids = calloc(threads, sizeof *ids);
+  if (!ids)
+    fatal("out-of-memory allocating checking threads");
+  for (unsigned i = 0; i != threads; i++)
+    if (pthread_create(ids + i, 0, check_blocks, 0))
+      fatal("could not start checking thread");
+  for (unsigned i = 0; i != threads; i++)
+    pthread_join(ids[i], 0);
+  free(ids);
+  for (unsigned kind = 0; kind != 4; kind++)
+    first[kind] = atomic_load(&checking.first[kind]);
+}
+
+// Maps the index 'ordinal' (starting at zero) of a clause among those of
+// the given kind back to its index in the file (starting at one).  This
+// is only needed once for reporting and thus a linear scan is good enough.
+
+static size_t clause_index(unsigned kind, size_t ordinal) {
+  for (size_t i = 0;; i++)
+    if (kind_of(i) == kind && !ordinal--)
+      return i + 1;
+}
+
+// Compacted clauses are always in a regular file, thus 'check_clause' finds
+// the position and original literals by parsing it again.
+
+static void check_compacted(size_t idx) {
+  if (idx == SIZE_MAX)
+    return;
+  clear_literals();
+  decode_compacted(idx);
+  check_clause(0, 0, idx + 1, literals.begin, literals.end);
+}
+
+static const int *stored_clause(unsigned kind, size_t ordinal,
+                                const int **end) {
+  const int *begin;
+  if (kind) {
+    const struct store *store = kind == 1   ? &units
+                                : kind == 2 ? &binaries
+                                            : &ternaries;
+    begin = store->begin + kind * ordinal;
+    *end = begin + kind;
   } else {
-    if (ch != ' ' && ch != '\t')
-      err(column, "expected %s or %s after 'cnf %zu'", space_name(' '),
-          space_name('\t'), specified_variables);
-    do
-      ch = next_char();
-    while (ch == ' ' || ch == '\t');
+    begin = arena.begin + offsets.begin[ordinal];
+    *end = arena.begin + offsets.begin[ordinal + 1];
   }
-  size_t specified_clauses;
-  {
-    if (!is_digit(ch))
-      err(column, "expected digit after 'p cnf %zu '", specified_variables);
-    const size_t maximum_clauses_limit = ~(size_t)0;
-    specified_clauses = ch - '0';
-    while (is_digit(ch = next_char())) {
-      if (strict && !specified_clauses)
-        srr(column - 1, "leading '0' digit in number of clauses");
-      if (maximum_clauses_limit / 10 < specified_clauses)
-        err(column, "maximum clauses limit exceeded");
-      specified_clauses *= 10;
-      unsigned digit = ch - '0';
-      if (maximum_clauses_limit - digit < specified_clauses)
-        err(column, "maximum clauses limit exceeded");
-      specified_clauses += digit;
-    }
-    if (ch == EOF) {
-      if (strict)
-        srr(column, "end-of-file after 'p cnf %zu %zu'", specified_variables,
-            specified_clauses);
-      else if (specified_clauses)
-        err(column, "end-of-file after 'p cnf %zu %zu'", specified_variables,
-            specified_clauses);
+  return begin;
+}
+
+static void check_stored_clause(size_t idx, const int *begin,
+                                const int *end) {
+  size_t lineno = 0, column = 0;
+  if (clause_positions) {
+    const struct position *position = positions.begin + idx - 1;
+    lineno = position->lineno, column = position->column;
+  }
+  check_clause(lineno, column, idx, begin, end);
+}
+
+static void check_stored(const size_t *first) {
+  size_t idx = 0;
+  const int *begin = 0, *end = 0;
+  for (unsigned kind = 0; kind != 4; kind++) {
+    const size_t ordinal = first[kind];
+    if (ordinal == SIZE_MAX)
+      continue;
+    const size_t other = clause_index(kind, ordinal);
+    if (idx && idx < other)
+      continue;
+    idx = other;
+    begin = stored_clause(kind, ordinal, &end);
+  }
+  if (idx)
+    check_stored_clause(idx, begin, end);
+}
+
+// With '--all-violations' the kernels are restarted after each unsatisfied
+// clause, while a single pass over the clause kinds (in file order) maps
+// the clauses found back to their index in the file.
+
+static void collect_violations(void) {
+  select_evaluator();
+  if (compact) {
+    const unsigned char *p = compacted.begin;
+    for (size_t i = 0; i != compacted.clauses; i++) {
+      clear_literals();
+      p = decode_next_compacted(p);
+      check_clause(0, 0, i + 1, literals.begin, literals.end);
     }
-    if (strict) {
-      if (ch == '\r') {
-        ch = next_char();
-        if (ch != '\n')
-          srr(column, "expected %s after %s after 'p cnf %zu %zu'",
-              space_name('\n'), space_name('\r'), specified_variables,
-              specified_clauses);
-      } else if (ch != '\n')
-        srr(column, "expected %s after 'p cnf %zu %zu'", space_name(' '),
-            specified_variables, specified_clauses);
-      ch = next_char();
+    return;
+  }
+  size_t count[4], next[4], ordinal[4] = {0, 0, 0, 0};
+  for (unsigned kind = 0; kind != 4; kind++) {
+    count[kind] = count_clauses(kind);
+    next[kind] =
+        count[kind] ? unsatisfied_clauses(kind, 0, count[kind]) : SIZE_MAX;
+  }
+  for (size_t i = 0; i != parsed_clauses; i++) {
+    if (next[0] == SIZE_MAX && next[1] == SIZE_MAX && next[2] == SIZE_MAX &&
+        next[3] == SIZE_MAX)
+      break;
+    const unsigned kind = kind_of(i);
+    const size_t current = ordinal[kind]++;
+    if (current != next[kind])
+      continue;
+    const int *end, *begin = stored_clause(kind, current, &end);
+    check_stored_clause(i + 1, begin, end);
+    next[kind] = current + 1 == count[kind]
+                     ? SIZE_MAX
+                     : unsatisfied_clauses(kind, current + 1, count[kind]);
+  }
+}
+
+static void check_model(void) {
+  msg("checking model to satisfy DIMACS formula");
+  if (complete)
+    check_completeness();
+  else
+    msg("partial model checking (without '--complete' nor '--pedantic')");
+  const double start = wall_clock_time();
+  if (violations.enabled) {
+    collect_violations();
+    vrb("checking clauses took %.2f seconds", wall_clock_time() - start);
+    report_violations();
+  } else {
+    size_t first[4];
+    find_unsatisfied(first);
+    vrb("checking clauses took %.2f seconds", wall_clock_time() - start);
+    if (compact)
+      check_compacted(first[0]);
+    else
+      check_stored(first);
+  }
+  msg("checked all %zu clauses to be satisfied by model", parsed_clauses);
+}
+
+#ifndef LIBDIMOCHECK
+
+// Same as 'srr' in strict mode and 'wrr' otherwise but at the recorded
+// position of the value in the (already closed) model file.
+
+static void exceeding(const struct exceeding_value *, const char *, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void exceeding(const struct exceeding_value *v, const char *fmt, ...) {
+  if (strict ? verbosity != INT_MIN : verbosity >= 0) {
+    fprintf(errors, "%s:%zu:%zu: %s: ", model_path, v->lineno, v->column,
+            strict ? "strict parsing error" : "warning");
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(errors, fmt, ap);
+    va_end(ap);
+    fputc('\n', errors);
+    fflush(errors);
+  }
+  if (strict)
+    failed(DIMOCHECK_PARSE_ERROR);
+}
+
+static void report_exceeding_values(void) {
+  size_t dimacs_variable_exceeded = 0;
+  for (const struct exceeding_value *v = exceeding_values.begin;
+       v != exceeding_values.end; v++) {
+    const int lit = v->lit;
+    if (abs(lit) <= maximum_dimacs_variable)
+      continue;
+    if (strict || !dimacs_variable_exceeded)
+      exceeding(v, "literal '%d' exceeds maximum DIMACS variable '%d'", lit,
+                maximum_dimacs_variable);
+    else if (dimacs_variable_exceeded == 1)
+      exceeding(v,
+          "another literal '%d' exceeds maximum DIMACS variable '%d' "
+          "(will stop warning about additional ones)",
+          lit, maximum_dimacs_variable);
+    dimacs_variable_exceeded++;
+  }
+  free(exceeding_values.begin);
+}
+
+// Reopen the DIMACS file after parsing the model and skip the header again,
+// which gives the same state as directly after 'parse_dimacs_header'.
+
+static void skip_input(size_t bytes) {
+  while (bytes) {
+    if (buffer.pos == buffer.end) {
+      if (refill_buffer() == EOF)
+        die("DIMACS file '%s' changed while checking", path);
+      bytes--;
     } else {
-      if (ch == 'c') {
-        while ((ch = next_char()) != '\n' && ch != EOF)
-          ;
-      } else {
-        if (!is_space(ch) && ch != EOF)
-          err(column, "expected %s or %s after 'p cnf %zu %zu'",
-              space_name(' '), space_name('\n'), specified_variables,
-              specified_clauses);
-        while (is_space(ch) && ch != '\n')
-          ch = next_char();
+      size_t available = buffer.end - buffer.pos;
+      if (available > bytes)
+        available = bytes;
+      buffer.pos += available;
+      bytes -= available;
+    }
+  }
+}
+
+static void parse_model_first(void) {
+  int ch = parse_dimacs_header();
+  const size_t saved_charno = charno();
+  const bool saved_end_of_file = end_of_file;
+  reset_parsing();
+  parse_model();
+  init_parsing(dimacs_path);
+  vrb("continuing parsing and checking clauses of '%s'", path);
+  skip_input(saved_charno);
+  end_of_file = saved_end_of_file;
+  msg("checking clauses of DIMACS while parsing");
+  parse_dimacs_clauses(ch);
+  if (!violations.unsatisfied)
+    msg("checked all %zu clauses to be satisfied by model", parsed_clauses);
+  report_exceeding_values();
+  if (complete)
+    check_completeness();
+  else
+    msg("partial model checking (without '--complete' nor '--pedantic')");
+  report_violations();
+}
+
+#endif
+
+// With '--cache <directory>' the parsed formula is saved as binary image
+// in that directory and later runs map this image into memory instead of
+// parsing the DIMACS file again.  The name of the image is a hash of the
+// real path of the DIMACS file and the parsing mode, i.e., whether parsing
+// is strict and clauses are compacted.  Its header records the size, the
+// modification time and a hash of the content of the DIMACS file, which
+// all have to match.  Warnings of the original parse are kept in the image
+// too and printed again, so the outcome is the same as without the cache.
+// Images are only written after parsing succeeded.  Clause positions are
+// not needed, since only regular files are cached.  Loaded clause stores
+// point into the (read-only) mapped image.
+
+#define CACHE_MAGIC UINT64_C(0x3145484341434d44)
+
+enum {
+  UNITS_SECTION,
+  BINARIES_SECTION,
+  TERNARIES_SECTION,
+  ARENA_SECTION,
+  OFFSETS_SECTION,
+  KINDS_SECTION,
+  COMPACTED_SECTION,
+  CHECKPOINTS_SECTION,
+  WARNINGS_SECTION,
+  NUMBER_OF_SECTIONS
+};
+
+struct cache_header {
+  uint64_t magic, mode, size, seconds, nanoseconds, hash;
+  uint64_t specified_variables, specified_clauses, parsed_clauses;
+  uint64_t kinds, compacted_clauses;
+  int64_t maximum_dimacs_variable;
+  uint64_t bytes[NUMBER_OF_SECTIONS];
+};
+
+STATE const char *cache_directory;
+
+STATE struct {
+  char *path;
+  struct stat dimacs;
+  unsigned char *image;
+  size_t size;
+  char *warnings;
+  size_t warnings_size;
+} cache;
+
+static uint64_t hash_bytes(uint64_t hash, const unsigned char *p, size_t n) {
+  const uint64_t multiplier = UINT64_C(0x9e3779b97f4a7c15);
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    hash = (((hash << 29) | (hash >> 35)) ^ word) * multiplier;
+  }
+  while (n--)
+    hash = (((hash << 29) | (hash >> 35)) ^ *p++) * multiplier;
+  return hash;
+}
+
+static bool hash_dimacs(uint64_t *hash) {
+  const int dimacs_fd = open(dimacs_path, O_RDONLY);
+  if (dimacs_fd < 0)
+    return false;
+  struct stat buf;
+  bool res = false;
+  if (!fstat(dimacs_fd, &buf) && buf.st_size == cache.dimacs.st_size) {
+    const size_t size = buf.st_size;
+    *hash = hash_bytes(size, 0, 0);
+    if (!size)
+      res = true;
+    else {
+      void *start = mmap(0, size, PROT_READ, MAP_PRIVATE, dimacs_fd, 0);
+      if (start != MAP_FAILED) {
+        (void)madvise(start, size, MADV_SEQUENTIAL);
+        *hash = hash_bytes(*hash, start, size);
+        munmap(start, size);
+        res = true;
       }
-      if (ch == EOF && specified_clauses)
-        err(column, "end-of-file after 'p cnf %zu %zu'", specified_variables,
-            specified_clauses);
     }
   }
-  msg("parsed header 'p cnf %zu %zu'", specified_variables, specified_clauses);
-  {
-    size_t variables_specified_exceeded = 0;
-    size_t clause_lineno = lineno;
-    size_t clause_column = column;
-    int last_lit = 0;
+  close(dimacs_fd);
+  return res;
+}
 
-    for (;;) {
+static uint64_t cache_mode(void) {
+  return strict | (uint64_t)compact << 1 | sizeof(size_t) << 8 |
+         sizeof(int) << 16;
+}
 
-      size_t token = column;
+static size_t padded(size_t bytes) { return (bytes + 7) & ~(size_t)7; }
 
-      if (ch == EOF) {
-      PARSED_END_OF_FILE:
-        if (last_lit)
-          err(column, "terminating zero '0' missing in last clause");
+static void cache_sections(const void **begin, size_t *bytes) {
+  const struct store *stores[4] = {&units, &binaries, &ternaries, &arena};
+  for (unsigned i = 0; i != 4; i++) {
+    begin[i] = stores[i]->begin;
+    bytes[i] = size_store(stores[i]) * sizeof *stores[i]->begin;
+  }
+  begin[OFFSETS_SECTION] = offsets.begin;
+  bytes[OFFSETS_SECTION] = (offsets.end - offsets.begin) * sizeof(size_t);
+  begin[KINDS_SECTION] = kinds.begin;
+  bytes[KINDS_SECTION] = (kinds.size + 3) / 4;
+  begin[COMPACTED_SECTION] = compacted.begin;
+  bytes[COMPACTED_SECTION] = compacted.end - compacted.begin;
+  begin[CHECKPOINTS_SECTION] = checkpoints.begin;
+  bytes[CHECKPOINTS_SECTION] =
+      (checkpoints.end - checkpoints.begin) * sizeof(size_t);
+  begin[WARNINGS_SECTION] = cache.warnings;
+  bytes[WARNINGS_SECTION] = cache.warnings_size;
+}
 
-        if (parsed_clauses < specified_clauses) {
-          const size_t missing_clauses = specified_clauses - parsed_clauses;
-          if (strict) {
-            if (missing_clauses == 1)
-              srr(column, "one clause missing (parsed %zu but %zu specified)",
-                  parsed_clauses, specified_clauses);
-            else
-              srr(column, "%zu clauses missing (parsed %zu but %zu specified)",
-                  missing_clauses, parsed_clauses, specified_clauses);
-          } else {
-            if (missing_clauses == 1)
-              wrn("one clause missing (parsed %zu but %zu specified)",
-                  parsed_clauses, specified_clauses);
-            else
-              wrn("%zu clauses missing (parsed %zu but %zu specified)",
-                  missing_clauses, parsed_clauses, specified_clauses);
-          }
-        } else if (parsed_clauses > specified_clauses) {
-          assert(!strict);
-          const size_t more_clauses_than_specified =
-              parsed_clauses - specified_clauses;
-          if (more_clauses_than_specified == 1)
-            wrn("one clause more than specified "
-                "(parsed %zu but %zu specified)",
-                parsed_clauses, specified_clauses);
-          else
-            wrn("%zu more clauses than specified "
-                "(parsed %zu but %zu specified)",
-                more_clauses_than_specified, parsed_clauses, specified_clauses);
-        }
+static bool init_cache(void) {
+  if (stat(dimacs_path, &cache.dimacs))
+    return false;
+  char *real = realpath(dimacs_path, 0);
+  if (!real)
+    return false;
+  const uint64_t hash =
+      hash_bytes(cache_mode(), (unsigned char *)real, strlen(real));
+  free(real);
+  const size_t len = strlen(cache_directory) + 32;
+  if (!(cache.path = malloc(len)))
+    fatal("out-of-memory allocating cache path");
+  snprintf(cache.path, len, "%s/%016llx.dimocheck", cache_directory,
+           (unsigned long long)hash);
+  return true;
+}
+
+static bool valid_image(const struct cache_header *header, size_t size) {
+  if (header->magic != CACHE_MAGIC || header->mode != cache_mode())
+    return false;
+  size_t bytes = sizeof *header;
+  for (unsigned i = 0; i != NUMBER_OF_SECTIONS; i++) {
+    if (header->bytes[i] > size)
+      return false;
+    bytes += padded(header->bytes[i]);
+  }
+  return bytes == size;
+}
+
+static bool load_cache(void) {
+  if (!init_cache())
+    return false;
+  const int cache_fd = open(cache.path, O_RDONLY);
+  if (cache_fd < 0) {
+    vrb("no cached formula '%s'", cache.path);
+    return false;
+  }
+  struct stat buf;
+  const size_t size = fstat(cache_fd, &buf) ? 0 : buf.st_size;
+  void *image = MAP_FAILED;
+  if (size >= sizeof(struct cache_header))
+    image = mmap(0, size, PROT_READ, MAP_PRIVATE, cache_fd, 0);
+  close(cache_fd);
+  if (image == MAP_FAILED) {
+    msg("could not load cached formula '%s'", cache.path);
+    return false;
+  }
+  const struct cache_header *header = image;
+  uint64_t hash;
+  if (!valid_image(header, size)) {
+    msg("invalid cached formula '%s'", cache.path);
+    munmap(image, size);
+    return false;
+  }
+  if (header->size != (uint64_t)cache.dimacs.st_size ||
+      header->seconds != (uint64_t)cache.dimacs.st_mtim.tv_sec ||
+      header->nanoseconds != (uint64_t)cache.dimacs.st_mtim.tv_nsec ||
+      !hash_dimacs(&hash) || header->hash != hash) {
+    msg("cached formula '%s' outdated", cache.path);
+    munmap(image, size);
+    return false;
+  }
+  cache.image = image;
+  cache.size = size;
+  unsigned char *p = cache.image + sizeof *header;
+  unsigned char *sections[NUMBER_OF_SECTIONS];
+  for (unsigned i = 0; i != NUMBER_OF_SECTIONS; i++)
+    sections[i] = p, p += padded(header->bytes[i]);
+  struct store *stores[4] = {&units, &binaries, &ternaries, &arena};
+  for (unsigned i = 0; i != 4; i++) {
+    stores[i]->begin = (int *)sections[i];
+    stores[i]->end = stores[i]->allocated =
+        stores[i]->begin + header->bytes[i] / sizeof(int);
+  }
+  offsets.begin = (size_t *)sections[OFFSETS_SECTION];
+  offsets.end = offsets.allocated =
+      offsets.begin + header->bytes[OFFSETS_SECTION] / sizeof(size_t);
+  kinds.begin = sections[KINDS_SECTION];
+  kinds.size = header->kinds;
+  kinds.capacity = header->bytes[KINDS_SECTION];
+  compacted.begin = sections[COMPACTED_SECTION];
+  compacted.end = compacted.allocated =
+      compacted.begin + header->bytes[COMPACTED_SECTION];
+  compacted.clauses = header->compacted_clauses;
+  checkpoints.begin = (size_t *)sections[CHECKPOINTS_SECTION];
+  checkpoints.end = checkpoints.allocated =
+      checkpoints.begin + header->bytes[CHECKPOINTS_SECTION] / sizeof(size_t);
+  specified_variables = header->specified_variables;
+  specified_clauses = header->specified_clauses;
+  parsed_clauses = header->parsed_clauses;
+  maximum_dimacs_variable = header->maximum_dimacs_variable;
+  if (verbosity >= 0) {
+    const char *q = (char *)sections[WARNINGS_SECTION];
+    const char *end = q + header->bytes[WARNINGS_SECTION];
+    while (q != end) {
+      const char *eol = memchr(q, '\n', end - q);
+      if (!eol)
+        eol = end;
+      fprintf(errors, "%s%.*s\n", dimacs_path, (int)(eol - q), q);
+      q = eol == end ? end : eol + 1;
+    }
+    fflush(errors);
+  }
+  msg("loaded %zu clauses from cached formula '%s'", parsed_clauses,
+      cache.path);
+  return true;
+}
+
+static bool write_image(FILE *out) {
+  const void *begin[NUMBER_OF_SECTIONS];
+  size_t bytes[NUMBER_OF_SECTIONS];
+  cache_sections(begin, bytes);
+  struct cache_header header;
+  memset(&header, 0, sizeof header);
+  header.magic = CACHE_MAGIC;
+  header.mode = cache_mode();
+  header.size = cache.dimacs.st_size;
+  header.seconds = cache.dimacs.st_mtim.tv_sec;
+  header.nanoseconds = cache.dimacs.st_mtim.tv_nsec;
+  if (!hash_dimacs(&header.hash))
+    return false;
+  header.specified_variables = specified_variables;
+  header.specified_clauses = specified_clauses;
+  header.parsed_clauses = parsed_clauses;
+  header.kinds = kinds.size;
+  header.compacted_clauses = compacted.clauses;
+  header.maximum_dimacs_variable = maximum_dimacs_variable;
+  for (unsigned i = 0; i != NUMBER_OF_SECTIONS; i++)
+    header.bytes[i] = bytes[i];
+  if (fwrite(&header, sizeof header, 1, out) != 1)
+    return false;
+  static const char padding[8];
+  for (unsigned i = 0; i != NUMBER_OF_SECTIONS; i++) {
+    const size_t padding_bytes = padded(bytes[i]) - bytes[i];
+    if (bytes[i] && fwrite(begin[i], bytes[i], 1, out) != 1)
+      return false;
+    if (padding_bytes && fwrite(padding, padding_bytes, 1, out) != 1)
+      return false;
+  }
+  return !ferror(out);
+}
+
+// The image is written to a temporary file first and then renamed, such
+// that concurrent checks of the same formula never see partial images.
+// Failing to write the image is not an error.
+
+static void write_cache(void) {
+  struct stat buf;
+  if (stat(dimacs_path, &buf) || buf.st_size != cache.dimacs.st_size ||
+      buf.st_mtim.tv_sec != cache.dimacs.st_mtim.tv_sec ||
+      buf.st_mtim.tv_nsec != cache.dimacs.st_mtim.tv_nsec) {
+    msg("not caching DIMACS file '%s' changed while parsing", dimacs_path);
+    return;
+  }
+  const size_t len = strlen(cache.path) + 8;
+  char *tmp = malloc(len);
+  if (!tmp)
+    fatal("out-of-memory allocating cache path");
+  snprintf(tmp, len, "%s.XXXXXX", cache.path);
+  const int tmp_fd = mkstemp(tmp);
+  if (tmp_fd >= 0) {
+    const mode_t mask = umask(0);
+    umask(mask);
+    (void)fchmod(tmp_fd, 0666 & ~mask);
+  }
+  FILE *out = tmp_fd < 0 ? 0 : fdopen(tmp_fd, "w");
+  bool written = out && write_image(out);
+  if (out && fclose(out))
+    written = false;
+  else if (!out && tmp_fd >= 0)
+    close(tmp_fd);
+  if (written && !rename(tmp, cache.path))
+    msg("cached formula in '%s'", cache.path);
+  else {
+    if (tmp_fd >= 0)
+      unlink(tmp);
+    msg("could not write cached formula '%s'", cache.path);
+  }
+  free(tmp);
+}
+
+// Parses the DIMACS file unless its cached image can be used.
+
+static void parse_dimacs(void) {
+  if (!cache_directory) {
+    parse_dimacs_clauses(parse_dimacs_header());
+    return;
+  }
+  if (load_cache())
+    return;
+  recorded_warnings = open_memstream(&cache.warnings, &cache.warnings_size);
+  if (!recorded_warnings)
+    fatal("out-of-memory recording warnings");
+  parse_dimacs_clauses(parse_dimacs_header());
+  fclose(recorded_warnings);
+  recorded_warnings = 0;
+  if (cache.path)
+    write_cache();
+}
+
+// Library functions declared in 'dimocheck.h'.  The parsed formula of a
+// context is swapped into the (thread local) clause stores when a library
+// function is entered and swapped back out into the context when it is
+// left.  Errors during a call jump back to the library function (see
+// 'failed'), which then closes the input and resets the model.
+
+struct dimocheck {
+  bool strict, complete, parsed;
+  char *path, *message;
+  size_t size;
+  int maximum_dimacs_variable;
+  size_t parsed_clauses, specified_variables, specified_clauses;
+  struct store units, binaries, ternaries, arena;
+  __typeof__(offsets) offsets;
+  __typeof__(kinds) kinds;
+  __typeof__(compacted) compacted;
+  __typeof__(checkpoints) checkpoints;
+  __typeof__(positions) positions;
+  bool clause_positions;
+};
+
+#define SWAP(A, B) \
+  do { \
+    __typeof__(A) TMP = (A); \
+    (A) = (B); \
+    (B) = TMP; \
+  } while (0)
+
+static void swap_formula(struct dimocheck *d) {
+  SWAP(maximum_dimacs_variable, d->maximum_dimacs_variable);
+  SWAP(specified_variables, d->specified_variables);
+  SWAP(specified_clauses, d->specified_clauses);
+  SWAP(units, d->units);
+  SWAP(binaries, d->binaries);
+  SWAP(ternaries, d->ternaries);
+  SWAP(arena, d->arena);
+  SWAP(offsets, d->offsets);
+  SWAP(kinds, d->kinds);
+  SWAP(compacted, d->compacted);
+  SWAP(checkpoints, d->checkpoints);
+  SWAP(positions, d->positions);
+  SWAP(clause_positions, d->clause_positions);
+}
+
+static void release_formula(struct dimocheck *d) {
+  free(units.begin);
+  free(binaries.begin);
+  free(ternaries.begin);
+  free(arena.begin);
+  free(offsets.begin);
+  free(kinds.begin);
+  free(compacted.begin);
+  free(checkpoints.begin);
+  free(positions.begin);
+  memset(&units, 0, sizeof units);
+  memset(&binaries, 0, sizeof binaries);
+  memset(&ternaries, 0, sizeof ternaries);
+  memset(&arena, 0, sizeof arena);
+  memset(&offsets, 0, sizeof offsets);
+  memset(&kinds, 0, sizeof kinds);
+  memset(&compacted, 0, sizeof compacted);
+  memset(&checkpoints, 0, sizeof checkpoints);
+  memset(&positions, 0, sizeof positions);
+  maximum_dimacs_variable = 0;
+  parsed_clauses = specified_variables = specified_clauses = 0;
+  clause_positions = false;
+  d->parsed = false;
+}
+
+static void reset_model(void) {
+  free(values.begin);
+  free(sparse.table);
+  free(violations.begin);
+  free(violations.literals.begin);
+  free(violations.variables.begin);
+  free(exceeding_values.begin);
+  memset(&values, 0, sizeof values);
+  memset(&sparse, 0, sizeof sparse);
+  memset(&violations, 0, sizeof violations);
+  memset(&exceeding_values, 0, sizeof exceeding_values);
+  maximum_model_variable = 0;
+  locating = 0;
+  clear_literals();
+}
+
+// The buffers for reading and sorting are thread local too and are freed
+// after each call, since the calling thread might never call us again.
+
+static void release_buffers(void) {
+  free(literals.begin);
+  free(keys.begin);
+  free(stream_buffer);
+  free(compressed_buffer);
+  memset(&literals, 0, sizeof literals);
+  memset(&keys, 0, sizeof keys);
+  stream_buffer = compressed_buffer = 0;
+}
+
+static void enter_library(struct dimocheck *d) {
+  static pthread_once_t classifier_selected = PTHREAD_ONCE_INIT;
+  pthread_once(&classifier_selected, select_classifier);
+  free(d->message);
+  d->message = 0;
+  if (!(errors = open_memstream(&d->message, &d->size)))
+    errors = stderr;
+  verbosity = -1;
+  strict = d->strict, strict_option = "--strict";
+  complete = d->complete, complete_option = "--complete";
+  dimacs_path = d->path;
+  library.active = true;
+  library.status = DIMOCHECK_SATISFIED;
+  library.clause = library.lineno = library.column = 0;
+  swap_formula(d);
+  parsed_clauses = d->parsed ? d->parsed_clauses : 0;
+}
+
+static int leave_library(struct dimocheck *d, struct dimocheck_result *r) {
+  if (close_file || mapped.begin || decoder != PLAIN)
+    reset_parsing();
+  memory.begin = memory.end = 0;
+  reset_model();
+  release_buffers();
+  swap_formula(d);
+  if (errors != stderr)
+    fclose(errors);
+  errors = 0;
+  library.active = false;
+  const int res = library.status;
+  if (r) {
+    r->status = res;
+    r->message = d->message ? d->message : "";
+    r->clause = library.clause;
+    r->lineno = library.lineno;
+    r->column = library.column;
+  }
+  return res;
+}
+
+static void set_memory(const char *name, const void *data, size_t size) {
+  memory.begin = data ? data : (const void *)"";
+  memory.end = memory.begin + (data ? size : 0);
+  memory.name = name ? name : "<memory>";
+}
+
+static void parse_formula(struct dimocheck *d, const char *name) {
+  if (d->parsed)
+    release_formula(d);
+  free(d->path);
+  if (!(d->path = strdup(name)))
+    fatal("out-of-memory copying formula path");
+  dimacs_path = d->path;
+  struct stat buf;
+  clause_positions = memory.begin || !strcmp(name, "-") ||
+                     (!stat(name, &buf) && !S_ISREG(buf.st_mode));
+  parse_dimacs();
+  d->parsed_clauses = parsed_clauses;
+  d->parsed = true;
+}
+
+static void require_formula(struct dimocheck *d) {
+  if (!d->parsed)
+    die("no formula parsed");
+}
+
+static void assign_values(const int *lits, size_t size) {
+  fit_values(maximum_dimacs_variable);
+  for (const int *p = lits; p != lits + size; p++) {
+    const int lit = *p;
+    if (!lit)
+      continue;
+    library.status = DIMOCHECK_PARSE_ERROR;
+    if (lit == INT_MIN)
+      die("invalid literal '%d' in values", lit);
+    const size_t idx = abs(lit);
+    if (strict && idx > (size_t)maximum_dimacs_variable)
+      die("literal '%d' exceeds maximum DIMACS variable '%d'", lit,
+          maximum_dimacs_variable);
+    const int value = value_of(idx);
+    if (value == -lit)
+      die("inconsistent values '%d' and '%d'", value, lit);
+    library.status = DIMOCHECK_SATISFIED;
+    if (!value)
+      assign(lit);
+    if ((int)idx > maximum_model_variable)
+      maximum_model_variable = idx;
+  }
+}
+
+dimocheck *dimocheck_init(unsigned flags) {
+  struct dimocheck *d = calloc(1, sizeof *d);
+  if (!d)
+    return 0;
+  d->strict = flags & DIMOCHECK_STRICT;
+  d->complete = flags & DIMOCHECK_COMPLETE;
+  return d;
+}
+
+void dimocheck_release(dimocheck *d) {
+  swap_formula(d);
+  release_formula(d);
+  free(d->path);
+  free(d->message);
+  free(d);
+}
+
+int dimocheck_parse_file(dimocheck *d, const char *file_path,
+                         struct dimocheck_result *r) {
+  enter_library(d);
+  if (!setjmp(library.failed))
+    parse_formula(d, file_path);
+  else
+    release_formula(d);
+  return leave_library(d, r);
+}
+
+int dimocheck_parse_buffer(dimocheck *d, const char *name, const void *data,
+                           size_t size, struct dimocheck_result *r) {
+  enter_library(d);
+  set_memory(name, data, size);
+  if (!setjmp(library.failed))
+    parse_formula(d, memory.name);
+  else
+    release_formula(d);
+  return leave_library(d, r);
+}
+
+int dimocheck_check_file(dimocheck *d, const char *file_path,
+                         struct dimocheck_result *r) {
+  enter_library(d);
+  if (!setjmp(library.failed)) {
+    require_formula(d);
+    model_path = file_path;
+    parse_model();
+    check_model();
+  }
+  return leave_library(d, r);
+}
+
+int dimocheck_check_buffer(dimocheck *d, const char *name, const void *data,
+                           size_t size, struct dimocheck_result *r) {
+  enter_library(d);
+  if (!setjmp(library.failed)) {
+    require_formula(d);
+    set_memory(name, data, size);
+    model_path = memory.name;
+    parse_model();
+    check_model();
+  }
+  return leave_library(d, r);
+}
 
-        if (variables_specified_exceeded)
-          wrn("parsed %zu literals exceeding specified maximum variable '%zu' "
-              "(maximum parsed variable index '%d')",
-              variables_specified_exceeded, specified_variables,
-              maximum_dimacs_variable);
+int dimocheck_check_values(dimocheck *d, const int *lits, size_t size,
+                           struct dimocheck_result *r) {
+  enter_library(d);
+  if (!setjmp(library.failed)) {
+    require_formula(d);
+    model_path = "<values>";
+    assign_values(lits, size);
+    check_model();
+  }
+  return leave_library(d, r);
+}
 
-        break;
-      }
+#ifndef LIBDIMOCHECK
 
-      if (is_space(ch)) {
-        if (strict)
-          srr(column, "unexpected %s (expected literal)", space_name(ch));
-        ch = next_char();
-        continue;
-      }
+// Checks the model of 'model_path' against the DIMACS file, where both are
+// only opened here, except in model-first mode.  Clause positions are only
+// stored for DIMACS files which can not be read again.
 
-      if (ch == 'c') {
-        if (strict)
-          srr(column, "unexpected comment 'c' (after 'p cnf' header)");
-        while ((ch = next_char()) != '\n')
-          if (ch == EOF) {
-            if (strict)
-              err(column, "end-of-file in comment");
-            else {
-              wrr(column, "end-of-file in comment");
-              goto PARSED_END_OF_FILE;
-            }
-          }
-        ch = next_char();
-        continue;
-      }
+static void stat_dimacs(void) {
+  struct stat buf;
+  if (!strcmp(dimacs_path, "-") ||
+      (!stat(dimacs_path, &buf) && !S_ISREG(buf.st_mode))) {
+    if (model_first)
+      die("DIMACS file '%s' not a regular file (required for '%s')",
+          dimacs_path, "--model-first");
+    clause_positions = true;
+  }
+}
 
-      if (!last_lit) {
-        clause_lineno = lineno;
-        clause_column = column;
-      }
+static void require_regular_dimacs(void) {
+  if (compact && clause_positions) {
+    msg("not compacting clauses of non-regular DIMACS file '%s'", dimacs_path);
+    compact = false;
+  }
+  if (cache_directory && clause_positions) {
+    msg("not caching non-regular DIMACS file '%s'", dimacs_path);
+    cache_directory = 0;
+  }
+}
 
-      int sign = 1;
-      if (ch == '-') {
-        ch = next_char();
-        if (strict && ch == '0')
-          srr(column, "invalid '0' after '-'");
-        if (!is_digit(ch))
-          err(column, "expected digit after '-'");
-        sign = -1;
-      } else if (!is_digit(ch))
-        err(column, "expected integer literal (digit or sign)");
+// In batch mode (several solution files) and manifest mode each model is
+// checked by a forked process, which thus has its own model and parsing
+// state.  In batch mode the (afterwards read-only) clause stores parsed by
+// the parent are shared copy-on-write, while in manifest mode each process
+// parses its own DIMACS file.  The output of each process goes to
+// temporary files, which are copied in the order the jobs were started.
 
-      const size_t maximum_variable_index = INT_MAX;
-      size_t idx = ch - '0';
-      while (is_digit(ch = next_char())) {
-        if (strict && !idx)
-          srr(column - 1, "leading '0' digit in literal");
-        if (maximum_variable_index / 10 < idx)
-          err(column, "literal exceeds maximum variable limit");
-        idx *= 10;
-        const unsigned digit = ch - '0';
-        if (maximum_variable_index - digit < idx)
-          err(column, "literal exceeds maximum variable limit");
-        idx += digit;
-      }
+static unsigned jobs = 1;
 
-      const int lit = sign * (int)idx;
-      assert(abs(lit) <= maximum_variable_index);
+static struct {
+  const char **begin, **end, **allocated;
+} solutions;
 
-      if (!is_space(ch) && ch != 'c')
-        err(column, "unexpected character after literal '%d'", lit);
+static struct job {
+  const char *dimacs, *solution;
+  size_t index, bytes;
+  pid_t pid;
+  FILE *out, *err;
+  int status;
+  bool done;
+  struct rusage usage;
+  char *error;
+} *queue;
 
-      if (strict && specified_clauses == parsed_clauses)
-        srr(token,
-            "too many clauses "
-            "(start of clause %zu but only %zu specified)",
-            parsed_clauses + 1, specified_clauses);
+static size_t queued;
 
-      if (idx > specified_variables) {
-        if (strict)
-          srr(token, "literal '%d' exceeds specified maximum variable '%zu'",
-              lit, specified_variables);
-        else {
-          if (!variables_specified_exceeded)
-            wrr(token, "literal '%d' exceeds specified maximum variable '%zu'",
-                lit, specified_variables);
-          else if (variables_specified_exceeded == 1)
-            wrr(token,
-                "another literal '%d' exceeds specified maximum variable '%zu' "
-                "(will stop warning about additional ones)",
-                lit, specified_variables);
-          variables_specified_exceeded++;
-        }
-      }
+// Parse and check times are written by the checking process into memory
+// shared with the parent (indexed by the position of the job in 'queue').
 
-      if (strict && idx && ch != ' ')
-        srr(column, "expected %s after literal '%d'", space_name(' '), lit);
+static struct timing {
+  double parse, check;
+} *timings;
 
-      if (strict && !idx) {
-        if (ch == '\r') {
-          ch = next_char();
-          if (ch != '\n')
-            srr(column,
-                "expected %s after carriage-return after terminating zero '0'",
-                space_name('\n'));
-        } else if (ch != '\n')
-          srr(column, "expected %s after terminating zero '0'",
-              space_name('\n'));
-      }
+static void push_solution(const char *solution) {
+  if (solutions.end == solutions.allocated) {
+    const size_t old_capacity = solutions.allocated - solutions.begin;
+    const size_t new_capacity = old_capacity ? 2 * old_capacity : 2;
+    solutions.begin =
+        realloc(solutions.begin, new_capacity * sizeof *solutions.begin);
+    if (!solutions.begin)
+      fatal("out-of-memory reallocating solution files");
+    solutions.end = solutions.begin + old_capacity;
+    solutions.allocated = solutions.begin + new_capacity;
+  }
+  *solutions.end++ = solution;
+}
 
-      if (strict && sign < 0 && !lit)
-        srr(token, "negative zero literal '-0'");
+// Since checking processes usually exit on the first error, the times are
+// recorded at exit, where 'parsed' is only set if parsing was completed.
 
-      if (lit) {
-        push_literal(lit);
-        if (idx > maximum_dimacs_variable)
-          maximum_dimacs_variable = idx;
-      } else {
-        parsed_clauses++;
-        push_clause(clause_lineno, clause_column);
-        clear_literals();
-      }
-      last_lit = lit;
+static struct {
+  struct timing *timing;
+  double started, parsed;
+} job_timing;
 
-      if (strict) {
-        assert((lit && ch == ' ') || (!lit && ch == '\n'));
-        ch = next_char();
-      }
+static void record_timing(void) {
+  const double now = wall_clock_time();
+  struct timing *timing = job_timing.timing;
+  if (job_timing.parsed) {
+    timing->parse = job_timing.parsed - job_timing.started;
+    timing->check = now - job_timing.parsed;
+  } else
+    timing->parse = now - job_timing.started;
+}
+
+static void check_job(struct job *job) {
+  job_timing.timing = timings + (job - queue);
+  job_timing.started = wall_clock_time();
+  atexit(record_timing);
+  model_path = job->solution;
+  if (job->dimacs) {
+    dimacs_path = job->dimacs;
+    stat_dimacs();
+    require_regular_dimacs();
+    if (model_first) {
+      parse_model_first();
+      return;
     }
+    parse_dimacs();
   }
-  reset_parsing();
-  msg("parsed %zu clauses with maximum variable index '%d'", parsed_clauses,
-      maximum_dimacs_variable);
+  parse_model();
+  job_timing.parsed = wall_clock_time();
+  check_model();
+}
 
-  if ((size_t) maximum_dimacs_variable < specified_variables) {
-    vrb ("maximum parsed variable '%d' smaller than specified variables '%zu'",
-         maximum_dimacs_variable, specified_variables);
-    maximum_dimacs_variable = specified_variables;
+static void start_job(struct job *job) {
+  if (!(job->out = tmpfile()) || !(job->err = tmpfile()))
+    fatal("could not create temporary output files");
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t pid = fork();
+  if (pid < 0)
+    fatal("could not fork checking process");
+  if (!pid) {
+    if (dup2(fileno(job->out), 1) < 0 || dup2(fileno(job->err), 2) < 0)
+      fatal("could not redirect output of checking process");
+    check_job(job);
+    exit(0);
   }
+  job->pid = pid;
 }
 
-static double average(double a, double b) { return b ? a / b : 0; }
-static double percent(double a, double b) { return average(100 * a, b); }
+static bool satisfied_job(const struct job *job) {
+  return WIFEXITED(job->status) && !WEXITSTATUS(job->status);
+}
 
-static void parse_model(void) {
+static void copy_output(FILE *from, FILE *to) {
+  char chars[1 << 12];
+  size_t bytes;
+  rewind(from);
+  while ((bytes = fread(chars, 1, sizeof chars, from)))
+    fwrite(chars, 1, bytes, to);
+  fclose(from);
+  fflush(to);
+}
 
-  init_parsing(model_path);
-  msg("parsing model '%s'", path);
-  if (strict) {
-    assert(strict_option);
-    msg("parsing in strict mode (due to '%s')", strict_option);
-  } else
-    msg("parsing in relaxed mode (without '--strict' nor '--pedantic')");
+// The first error line of a failed job is kept for '--results'.
 
-  size_t parsed_values = 0, positive_values = 0, negative_values = 0;
+static char *first_error(FILE *err) {
+  char *line = 0;
+  size_t len = 0;
+  ssize_t read;
+  rewind(err);
+  while ((read = getline(&line, &len, err)) > 0)
+    if (strstr(line, "error")) {
+      if (line[read - 1] == '\n')
+        line[read - 1] = 0;
+      return line;
+    }
+  free(line);
+  return 0;
+}
 
-  bool reported_missing_status_line = false;
-  bool reported_found_status_line = false;
-  size_t dimacs_variable_exceeded = 0;
-  size_t first_vline_section = 0;
-  size_t first_status_line = 0;
-  size_t value_sections = 0;
-  size_t status_lines = 0;
+static void finish_job(struct job *job) {
+  if (!satisfied_job(job))
+    job->error = first_error(job->err);
+  copy_output(job->out, stdout);
+  copy_output(job->err, stderr);
+  if (verbosity == INT_MIN)
+    return;
+  printf("s %s",
+         satisfied_job(job) ? "MODEL_SATISFIES_FORMULA" : "MODEL_CHECK_FAILED");
+  if (job->dimacs)
+    printf(" %s", job->dimacs);
+  printf(" %s\n", job->solution);
+  fflush(stdout);
+}
 
-  int ch = next_char();
-  for (;;) {
+// Runs the jobs in 'queue' with up to 'jobs' processes at the same time.
+// A new job is started as soon as any process finished.  Returns the
+// number of jobs which failed.
 
-    if (ch == EOF)
-      break;
+static size_t run_jobs(size_t count) {
+  queued = count;
+  timings = mmap(0, count * sizeof *timings + 1, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (timings == MAP_FAILED)
+    fatal("could not map shared timing results");
+  size_t started = 0, finished = 0, failed = 0;
+  unsigned running = 0;
+  while (finished != count) {
+    while (running < jobs && started != count)
+      start_job(queue + started++), running++;
+    int status;
+    struct rusage usage;
+    const pid_t pid = wait4(-1, &status, 0, &usage);
+    if (pid < 0)
+      fatal("waiting for checking process failed");
+    struct job *job = queue + finished;
+    while (job->pid != pid)
+      job++;
+    job->status = status;
+    job->usage = usage;
+    job->done = true;
+    running--;
+    while (finished != started && queue[finished].done) {
+      job = queue + finished++;
+      finish_job(job);
+      if (!satisfied_job(job))
+        failed++;
+    }
+  }
+  return failed;
+}
 
-    if (is_space(ch)) {
-      if (strict)
-        srr(column, "unexpected %s (expected 'c' or 's')", space_name(ch));
-      ch = next_char();
-      continue;
+static void free_jobs(void) {
+  for (struct job *job = queue; job != queue + queued; job++) {
+    if (job->dimacs) {
+      free((char *)job->dimacs);
+      free((char *)job->solution);
     }
+    free(job->error);
+  }
+  free(queue);
+  if (timings)
+    munmap(timings, queued * sizeof *timings + 1);
+}
 
-    size_t token = column;
-    if (ch == 'c') {
-      while ((ch = next_char()) != '\n')
-        if (ch == EOF)
-          err(column, "end-of-file in comment");
-      ch = next_char();
+static int check_models(void) {
+  const size_t count = solutions.end - solutions.begin;
+  msg("checking %zu models with %u jobs", count, jobs);
+  if (!(queue = calloc(count, sizeof *queue)))
+    fatal("out-of-memory allocating checking jobs");
+  for (size_t i = 0; i != count; i++)
+    queue[i].solution = solutions.begin[i];
+  const size_t failed = run_jobs(count);
+  if (failed)
+    msg("%zu of %zu models failed", failed, count);
+  else
+    msg("all %zu models satisfy formula", count);
+  return failed ? 1 : 0;
+}
 
-      continue; // With outer 'for' loop.
-    }
+// With '--manifest <file>' each non-empty line of the file which does not
+// start with '#' lists a DIMACS file and a solution file (separated by
+// white space).  The largest pairs are checked first to avoid waiting for
+// a single large check at the end.  With '--results <file>' a line with
+// status, first error line, parse and check times and the maximum resident
+// set size of each pair is written in CSV format (in the order of the
+// manifest).  In model-first mode checking is part of parsing.
 
-    if (ch == 's') {
-      const size_t start_of_status_line = lineno;
-      ch = next_char();
-      if (strict) {
-        if (ch != ' ')
-          srr(column, "expected %s after 's'", space_name(' '));
-        ch = next_char();
-      } else {
-        if (ch != ' ' && ch != '\t')
-          srr(column, "expected %s or %s after 's'", space_name(' '),
-              space_name('\t'));
-        do
-          ch = next_char();
-        while (ch == ' ' || ch == '\t');
-      }
-      for (const char *p = "SATISFIABLE"; *p; p++)
-        if (ch != *p)
-          err(token, "invalid status line (expected 's SATISFIABLE')");
-        else
-          ch = next_char();
-      if (strict) {
-        if (ch == '\r') {
-          ch = next_char();
-          if (ch != '\n')
-            srr(column, "expected %s after %s after 's SATISFIABLE'",
-                space_name('\n'), space_name('\r'));
-        }
-        if (ch != '\n')
-          srr(column, "expected %s after 's SATISFIABLE'", space_name('\n'));
-        if (strict && status_lines)
-          srr(token, "second 's SATISFIABLE' line (first at line %zu)",
-              first_status_line);
-      } else {
-        while (ch != EOF && ch != '\n' && is_space(ch))
-          ch = next_char();
-      }
-      if (!reported_found_status_line) {
-        msg("found 's SATISFIABLE' status line");
-        reported_found_status_line = true;
-      }
-      if (!status_lines++)
-        first_status_line = start_of_status_line;
+static const char *manifest_path;
+static const char *results_path;
 
-      if (ch == '\n')
-        ch = next_char();
-      continue; // With outer 'for' loop.
+static size_t file_size(const char *file_path) {
+  struct stat buf;
+  return stat(file_path, &buf) ? 0 : buf.st_size;
+}
+
+static size_t read_manifest(void) {
+  FILE *manifest = fopen(manifest_path, "r");
+  if (!manifest)
+    die("can not open and read manifest '%s'", manifest_path);
+  size_t count = 0, capacity = 0, lineno = 0, len = 0;
+  char *line = 0;
+  while (getline(&line, &len, manifest) > 0) {
+    lineno++;
+    char *p = line;
+    while (is_space(*p))
+      p++;
+    if (!*p || *p == '#')
+      continue;
+    char *dimacs = strtok(p, " \t\r\n");
+    char *solution = strtok(0, " \t\r\n");
+    if (!solution || strtok(0, " \t\r\n"))
+      die("%s:%zu: expected DIMACS and solution file", manifest_path, lineno);
+    if (count == capacity) {
+      capacity = capacity ? 2 * capacity : 16;
+      if (!(queue = realloc(queue, capacity * sizeof *queue)))
+        fatal("out-of-memory reallocating manifest jobs");
     }
+    struct job *job = queue + count++;
+    memset(job, 0, sizeof *job);
+    if (!(job->dimacs = strdup(dimacs)) || !(job->solution = strdup(solution)))
+      fatal("out-of-memory copying manifest paths");
+    job->index = count - 1;
+    job->bytes = file_size(dimacs) + file_size(solution);
+  }
+  free(line);
+  fclose(manifest);
+  return count;
+}
 
-    if (ch == 'v') {
+static int cmp_jobs(const void *p, const void *q) {
+  const struct job *a = p, *b = q;
+  if (a->bytes != b->bytes)
+    return a->bytes < b->bytes ? 1 : -1;
+  return (a->index > b->index) - (a->index < b->index);
+}
 
-      if (!status_lines) {
-        if (strict)
-          srr(column, "'v' line without 's SATISFIABLE' status line");
-        else if (!reported_missing_status_line) {
-          wrr(column, "'v' line without 's SATISFIABLE' status line");
-          reported_missing_status_line = true;
-        }
-      }
+static void write_csv_string(FILE *out, const char *str) {
+  fputc('"', out);
+  for (const char *p = str; *p; p++) {
+    if (*p == '"')
+      fputc('"', out);
+    fputc(*p, out);
+  }
+  fputc('"', out);
+}
 
-      if (value_sections++) {
-        if (strict)
-          srr(column, "second 'v' line (first at line %zu)",
-              first_vline_section);
-        else if (value_sections == 2)
-          wrr(column, "second 'v' line section (first at line %zu)",
-              first_vline_section);
-        else if (value_sections == 3)
-          wrr(column, "third 'v' line section (will stop warning about more)");
-      }
+// The maximum resident set size 'ru_maxrss' is given in kilobytes on
+// Linux but in bytes on macOS.
+
+static size_t resident_set_bytes(const struct rusage *usage) {
+  size_t res = (size_t)usage->ru_maxrss;
+#ifndef __APPLE__
+  res <<= 10;
+#endif
+  return res;
+}
+
+static void write_results(struct job **order, size_t count) {
+  FILE *out = fopen(results_path, "w");
+  if (!out)
+    die("can not write results '%s'", results_path);
+  fputs("dimacs,solution,status,error,parse_seconds,check_seconds,"
+        "maximum_resident_set_size\n",
+        out);
+  for (size_t i = 0; i != count; i++) {
+    const struct job *job = order[i];
+    const struct timing *timing = timings + (job - queue);
+    write_csv_string(out, job->dimacs);
+    fputc(',', out);
+    write_csv_string(out, job->solution);
+    fprintf(out, ",%s,", satisfied_job(job) ? "MODEL_SATISFIES_FORMULA"
+                                            : "MODEL_CHECK_FAILED");
+    write_csv_string(out, job->error ? job->error : "");
+    fprintf(out, ",%.3f,%.3f,%zu\n", timing->parse, timing->check,
+            resident_set_bytes(&job->usage));
+  }
+  if (fclose(out))
+    die("can not write results '%s'", results_path);
+  msg("wrote results of %zu checks to '%s'", count, results_path);
+}
+
+static int check_manifest(void) {
+  const size_t count = read_manifest();
+  msg("checking %zu pairs of '%s' with %u jobs", count, manifest_path, jobs);
+  qsort(queue, count, sizeof *queue, cmp_jobs);
+  const size_t failed = run_jobs(count);
+  if (results_path) {
+    struct job **order = malloc((count + 1) * sizeof *order);
+    if (!order)
+      fatal("out-of-memory allocating manifest order");
+    for (size_t i = 0; i != count; i++)
+      order[queue[i].index] = queue + i;
+    write_results(order, count);
+    free(order);
+  }
+  if (failed)
+    msg("%zu of %zu checks failed", failed, count);
+  else
+    msg("all %zu checks succeeded", count);
+  return failed ? 1 : 0;
+}
+
+static void can_not_combine(const char *a, const char *b) {
+  if (a && b)
+    die("can not combine '%s' and '%s' (try '-h')", a, b);
+}
+
+size_t maximum_resident_set_size(void) {
+  struct rusage u;
+  return getrusage(RUSAGE_SELF, &u) ? 0 : resident_set_bytes(&u);
+}
+
+static double process_time(void) {
+  double res = 0;
+  struct rusage u;
+  if (!getrusage(RUSAGE_SELF, &u)) {
+    res = u.ru_utime.tv_sec + 1e-6 * u.ru_utime.tv_usec;
+    res += u.ru_stime.tv_sec + 1e-6 * u.ru_stime.tv_usec;
+  }
+  return res;
+}
+
+// With '--serve <socket>' parsed formulas are kept resident and models are
+// checked on request of clients connecting to the Unix domain socket.  A
+// request consists of two lines, the path of the DIMACS file and the path
+// of the solution file, where the solution path '-' means that the rest of
+// the request (until the client shuts down writing) is the solution.  Each
+// formula is parsed by its own formula process, which then forks a checking
+// process for each request sharing the clauses copy-on-write (as in batch
+// mode).  The output of the checking process (after the replayed output of
+// parsing the formula) is sent back followed by the status line.  Formula
+// processes which used least recently are evicted (asked to terminate by
+// closing their channel) if the resident set size of all formula processes
+// exceeds the budget given with '--serve-memory'.  Formulas are parsed
+// again if the DIMACS file changed.
+
+static const char *serve_path;
+static const char *connect_path;
+static size_t serve_memory;
 
-      if (!first_vline_section)
-        first_vline_section = lineno;
+static struct formula {
+  char *path;
+  struct timespec modified;
+  off_t size;
+  pid_t pid;
+  int channel;
+  bool ready;
+  size_t bytes;
+  uint64_t used;
+} *formulas;
 
-      for (;;) { // Ranges over all 'v' lines of one section.
+static size_t resident_formulas, capacity_formulas;
+static uint64_t formula_stamp;
 
-        ch = next_char();
-        if (strict) {
-          if (ch != ' ')
-            srr(column, "expected %s after 'v'", space_name(' '));
-          ch = next_char();
-        } else {
-        PARSE_SPACE_AFTER_V:
-          if (ch != ' ' && ch != '\t')
-            err(column, "expected %s or %s after 'v'", space_name(' '),
-                space_name('\t'));
-          while (ch == ' ' || ch == '\t')
-            ch = next_char();
-        }
+// Connected clients which did not complete their request lines yet.  They
+// are polled together with the formula channels, so that slow or idle
+// clients do not delay requests of other clients.
 
-        for (;;) { // Ranges over values in one 'v' line.
+#define REQUEST_TIMEOUT 10.0
 
-          if (ch == EOF)
-            err(column, "end-of-file in 'v' line");
+static struct client {
+  int fd;
+  unsigned lines;
+  size_t size;
+  double deadline;
+  char request[2 * PATH_MAX + 2];
+} *clients;
 
-          if (!strict && ch == '\n') {
-          CONTINUE_IN_VLINE_AFTER_NEW_LINE:
-            ch = next_char();
-            if (ch != 'v')
-              err(column, "expected 'v' as first character");
-            ch = next_char();
-            goto PARSE_SPACE_AFTER_V;
-          }
+static size_t pending_clients, capacity_clients;
+static int listening = -1;
+static volatile sig_atomic_t stop_serving;
 
-          token = column;
+// State of a formula process and its checking processes.
 
-          int sign = 1;
-          if (ch == '-') {
-            ch = next_char();
-            if (strict && ch == '0')
-              srr(column, "invalid '0' after '-'");
-            if (!is_digit(ch))
-              err(column, "expected digit after '-'");
-            sign = -1;
-          } else if (!is_digit(ch))
-            err(column, "expected integer literal (digit or sign)");
+static struct {
+  int channel;
+  pid_t pid;
+  bool parsed;
+  char *output;
+  size_t size;
+} served;
 
-          const size_t maximum_variable_index = INT_MAX;
-          size_t idx = ch - '0';
-          while (is_digit(ch = next_char())) {
-            if (strict && !idx)
-              srr(column - 1, "leading '0' digit in literal");
-            if (maximum_variable_index / 10 < idx)
-              err(column, "literal exceeds maximum variable limit");
-            idx *= 10;
-            const unsigned digit = ch - '0';
-            if (maximum_variable_index - digit < idx)
-              err(column, "literal exceeds maximum variable limit");
-            idx += digit;
-          }
+static bool served_satisfied;
 
-          const int lit = sign * (int)idx;
-          assert(abs(lit) <= maximum_variable_index);
+static void write_all(int out, const void *ptr, size_t bytes) {
+  const char *p = ptr;
+  while (bytes) {
+    const ssize_t written = write(out, p, bytes);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return;
+    p += written, bytes -= written;
+  }
+}
 
-          if (idx > maximum_dimacs_variable) {
-            if (strict)
-              srr(token, "literal '%d' exceeds maximum DIMACS variable '%d'",
-                  lit, maximum_dimacs_variable);
-            else if (!dimacs_variable_exceeded)
-              wrr(token, "literal '%d' exceeds maximum DIMACS variable '%d'",
-                  lit, maximum_dimacs_variable);
-            else if (dimacs_variable_exceeded == 1)
-              wrr(token,
-                  "another literal '%d' exceeds maximum DIMACS variable '%d' "
-                  "(will stop warning about additional ones)",
-                  lit, maximum_dimacs_variable);
-            dimacs_variable_exceeded++;
-          }
+static void send_failure(int client, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
 
-          if (verbosity == INT_MAX) {
-            if (lit)
-              printf(PREFIX "parsed value literal '%d'\n", lit);
-            else
-              printf(PREFIX "parsed terminating zero '0'\n");
-            fflush(stdout);
-          }
+static void send_failure(int client, const char *fmt, ...) {
+  char line[PATH_MAX + 128];
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf(line, sizeof line - 32, fmt, ap);
+  va_end(ap);
+  if (len < 0 || (size_t)len > sizeof line - 32)
+    len = sizeof line - 32;
+  len += sprintf(line + len, "\ns MODEL_CHECK_FAILED\n");
+  write_all(client, line, len);
+}
 
-          if (idx) {
-            parsed_values++;
-            if (idx > maximum_model_variable)
-              maximum_model_variable = idx;
-          }
+static void print_verdict(void) {
+  printf("s %s\n", served_satisfied ? "MODEL_SATISFIES_FORMULA"
+                                    : "MODEL_CHECK_FAILED");
+  fflush(stdout);
+}
 
-          if (idx >= values.size)
-            fit_values(idx);
+static void check_request(int client, const char *solution) {
+  signal(SIGCHLD, SIG_DFL);
+  close(served.channel);
+  if (dup2(client, 1) < 0 || dup2(client, 2) < 0 ||
+      (!strcmp(solution, "-") && dup2(client, 0) < 0))
+    fatal("could not redirect output of checking process");
+  close(client);
+  fwrite(served.output, 1, served.size, stdout);
+  fflush(stdout);
+  atexit(print_verdict);
+  model_path = solution;
+  parse_model();
+  check_model();
+  served_satisfied = true;
+  exit(0);
+}
 
-          assert(idx <= (size_t)INT_MAX);
-          const int old_value = values.begin[idx];
-          const int new_value = lit;
+static int receive_request(char *solution, size_t size) {
+  char control[CMSG_SPACE(sizeof(int))];
+  struct iovec iov = {.iov_base = solution, .iov_len = size - 1};
+  struct msghdr header = {.msg_iov = &iov,
+                          .msg_iovlen = 1,
+                          .msg_control = control,
+                          .msg_controllen = sizeof control};
+  ssize_t bytes;
+  do
+    bytes = recvmsg(served.channel, &header, 0);
+  while (bytes < 0 && errno == EINTR);
+  if (bytes <= 0)
+    return -1;
+  solution[bytes] = 0;
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+  if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS)
+    return -1;
+  int client;
+  memcpy(&client, CMSG_DATA(cmsg), sizeof client);
+  return client;
+}
 
-          if (old_value && old_value != new_value)
-            err(token, "old value '%d' overwritten by new value '%d'",
-                old_value, new_value);
+// Reports the resident set size to the server and then handles requests
+// until the server closes the channel.  If parsing failed each request is
+// answered with the output of parsing and a failed status line.
 
-          if (strict && old_value) {
-            assert(old_value == new_value);
-            srr(token, "value '%d' set twice", new_value);
-          }
+static void serve_checks(void) {
+  fflush(stdout);
+  fflush(stderr);
+  FILE *output = fdopen(dup(1), "r");
+  if (!output || fseek(output, 0, SEEK_SET))
+    fatal("could not read output of parsing formula");
+  char chars[1 << 12];
+  size_t bytes;
+  FILE *copy = open_memstream(&served.output, &served.size);
+  if (!copy)
+    fatal("out-of-memory copying output of parsing formula");
+  while ((bytes = fread(chars, 1, sizeof chars, output)))
+    fwrite(chars, 1, bytes, copy);
+  fclose(copy);
+  fclose(output);
+  const size_t resident = maximum_resident_set_size();
+  write_all(served.channel, &resident, sizeof resident);
+  signal(SIGCHLD, SIG_IGN);
+  char solution[PATH_MAX + 1];
+  int client;
+  while ((client = receive_request(solution, sizeof solution)) >= 0) {
+    if (!served.parsed) {
+      write_all(client, served.output, served.size);
+      write_all(client, "s MODEL_CHECK_FAILED\n", 21);
+    } else {
+      fflush(stdout);
+      const pid_t pid = fork();
+      if (!pid)
+        check_request(client, solution);
+      if (pid < 0)
+        send_failure(client, "dimocheck: error: could not fork checker");
+    }
+    close(client);
+  }
+  _exit(0);
+}
 
-          if (old_value != new_value) {
-            if (new_value < 0)
-              negative_values++;
-            else
-              positive_values++;
-          }
-          values.begin[idx] = new_value;
+// Parsing errors exit the formula process, which then keeps answering.
 
-          if (lit) {
+static void failed_formula(void) {
+  if (getpid() == served.pid && !served.parsed)
+    serve_checks();
+}
 
-            if (strict) {
-              if (ch != ' ')
-                srr(column, "expected %s after '%d'", space_name(' '), lit);
+static void serve_formula(struct formula *formula, int channel) {
+  close(listening);
+  for (struct client *c = clients; c != clients + pending_clients; c++)
+    close(c->fd);
+  for (struct formula *f = formulas; f != formulas + resident_formulas; f++)
+    if (f != formula)
+      close(f->channel);
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+  served.channel = channel;
+  served.pid = getpid();
+  FILE *output = tmpfile();
+  if (!output || dup2(fileno(output), 1) < 0 || dup2(fileno(output), 2) < 0)
+    fatal("could not redirect output of formula process");
+  fclose(output);
+  dimacs_path = formula->path;
+  stat_dimacs();
+  require_regular_dimacs();
+  atexit(failed_formula);
+  parse_dimacs();
+  served.parsed = true;
+  serve_checks();
+}
 
-              ch = next_char();
+static void spawn_formula(const char *dimacs, const struct stat *buf) {
+  if (resident_formulas == capacity_formulas) {
+    capacity_formulas = capacity_formulas ? 2 * capacity_formulas : 16;
+    formulas = realloc(formulas, capacity_formulas * sizeof *formulas);
+    if (!formulas)
+      fatal("out-of-memory reallocating resident formulas");
+  }
+  struct formula *formula = formulas + resident_formulas;
+  memset(formula, 0, sizeof *formula);
+  if (!(formula->path = strdup(dimacs)))
+    fatal("out-of-memory copying formula path");
+  formula->modified = buf->st_mtim;
+  formula->size = buf->st_size;
+  int pair[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, pair))
+    fatal("could not create channel to formula process");
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t pid = fork();
+  if (pid < 0)
+    fatal("could not fork formula process");
+  if (!pid) {
+    close(pair[0]);
+    serve_formula(formula, pair[1]);
+  }
+  close(pair[1]);
+  formula->pid = pid;
+  formula->channel = pair[0];
+  resident_formulas++;
+  msg("parsing formula '%s' in process %d", dimacs, (int)pid);
+}
 
-            } else {
-              if (!is_space(ch))
-                err(column, "expected white-space after '%d'", lit);
-              while (ch != '\n' && is_space(ch))
-                ch = next_char();
-              if (ch == '\n')
-                goto CONTINUE_IN_VLINE_AFTER_NEW_LINE;
-            }
+static void remove_formula(struct formula *formula) {
+  close(formula->channel);
+  free(formula->path);
+  *formula = formulas[--resident_formulas];
+}
 
-          } else {
+static void evict_formulas(const struct formula *keep) {
+  if (!serve_memory)
+    return;
+  for (;;) {
+    size_t bytes = 0;
+    struct formula *lru = 0;
+    for (struct formula *f = formulas; f != formulas + resident_formulas;
+         f++) {
+      if (!f->ready)
+        continue;
+      bytes += f->bytes;
+      if (f != keep && (!lru || f->used < lru->used))
+        lru = f;
+    }
+    if (bytes <= serve_memory || !lru)
+      return;
+    msg("evicting formula '%s' (%.0f MB)", lru->path,
+        lru->bytes / (double)(1 << 20));
+    remove_formula(lru);
+    if (keep == formulas + resident_formulas)
+      keep = lru;
+  }
+}
 
-            if (strict) {
-              if (ch == '\r') {
-                ch = next_char();
-                if (ch != '\n')
-                  srr(column, "expected %s after %s after '0'",
-                      space_name('\n'), space_name('\r'));
-              } else if (ch != '\n')
-                srr(column, "expected %s after '0'", space_name('\n'));
+static bool send_request(struct formula *formula, int client,
+                         const char *solution) {
+  char control[CMSG_SPACE(sizeof(int))];
+  memset(control, 0, sizeof control);
+  struct iovec iov = {.iov_base = (void *)solution,
+                      .iov_len = strlen(solution)};
+  struct msghdr header = {.msg_iov = &iov,
+                          .msg_iovlen = 1,
+                          .msg_control = control,
+                          .msg_controllen = sizeof control};
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &client, sizeof client);
+  return sendmsg(formula->channel, &header, MSG_NOSIGNAL) >= 0;
+}
 
-            } else {
-              while (ch != '\n' && is_space(ch))
-                ch = next_char();
-              if (ch == 'c') {
-                while ((ch = next_char()) != '\n')
-                  if (ch == EOF) {
-                    wrr(column, "end-of-file in comment after '0'");
-                    break;
-                  }
-              } else if (ch != EOF && ch != '\n')
-                err(column, "expected %s after '0'", space_name('\n'));
-            }
+// The request lines are complete and are split into the two paths.
 
-            if (ch != EOF) {
-              assert(ch == '\n');
-              ch = next_char();
-            }
-            goto CONTINUE_WITH_OUTER_LOOP;
-          }
+static void handle_request(struct client *c) {
+  const int client = c->fd;
+  char *dimacs = c->request, *solution = strchr(dimacs, '\n');
+  *solution++ = 0;
+  *strchr(solution, '\n') = 0;
+  if (!*dimacs || !*solution || strlen(dimacs) >= PATH_MAX ||
+      strlen(solution) >= PATH_MAX) {
+    send_failure(client, "dimocheck: error: invalid request");
+    return;
+  }
+  struct stat buf;
+  if (stat(dimacs, &buf)) {
+    send_failure(client, "dimocheck: error: can not open and read '%s'",
+                 dimacs);
+    return;
+  }
+  vrb("checking '%s' against '%s'", solution, dimacs);
+  struct formula *formula = formulas;
+  while (formula != formulas + resident_formulas &&
+         strcmp(formula->path, dimacs))
+    formula++;
+  if (formula != formulas + resident_formulas &&
+      (formula->size != buf.st_size ||
+       formula->modified.tv_sec != buf.st_mtim.tv_sec ||
+       formula->modified.tv_nsec != buf.st_mtim.tv_nsec)) {
+    msg("formula '%s' changed", dimacs);
+    remove_formula(formula);
+    formula = formulas + resident_formulas;
+  }
+  if (formula == formulas + resident_formulas) {
+    spawn_formula(dimacs, &buf);
+    formula = formulas + resident_formulas - 1;
+  }
+  formula->used = ++formula_stamp;
+  if (!send_request(formula, client, solution)) {
+    remove_formula(formula);
+    send_failure(client, "dimocheck: error: formula process of '%s' failed",
+                 dimacs);
+  }
+}
 
-        } // End of 'for' loop over all all values in one 'v' line.
+static void accept_client(void) {
+  const int fd = accept(listening, 0, 0);
+  if (fd < 0)
+    return;
+  if (pending_clients == capacity_clients) {
+    capacity_clients = capacity_clients ? 2 * capacity_clients : 16;
+    clients = realloc(clients, capacity_clients * sizeof *clients);
+    if (!clients)
+      fatal("out-of-memory reallocating pending clients");
+  }
+  struct client *c = clients + pending_clients++;
+  c->fd = fd;
+  c->lines = 0;
+  c->size = 0;
+  c->deadline = wall_clock_time() + REQUEST_TIMEOUT;
+}
 
-      } // End of 'for' loop over all 'v' lines of one section.
+static void remove_client(struct client *c) {
+  close(c->fd);
+  *c = clients[--pending_clients];
+}
 
-      continue; // With outer loop (new 'c', 's, or 'v' lines).
-    }
+// Reads what is available of the request lines without blocking.  Only
+// the bytes up to the second new-line are consumed (by peeking first), as
+// the solution itself follows the request lines if its path is '-'.
+// Returns 'true' if the client is done (answered or handed over).
 
-    err(column, "expected 'c', 's' or 'v' as first character");
+static bool receive_request_lines(struct client *c) {
+  char *begin = c->request + c->size;
+  const size_t available = sizeof c->request - 1 - c->size;
+  const ssize_t bytes = recv(c->fd, begin, available, MSG_PEEK | MSG_DONTWAIT);
+  if (bytes < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    return false;
+  if (bytes <= 0) {
+    send_failure(c->fd, "dimocheck: error: invalid request");
+    return true;
+  }
+  size_t consumed = 0;
+  while (consumed != (size_t)bytes && c->lines != 2)
+    if (begin[consumed++] == '\n')
+      c->lines++;
+  if (recv(c->fd, begin, consumed, MSG_DONTWAIT) != (ssize_t)consumed) {
+    send_failure(c->fd, "dimocheck: error: invalid request");
+    return true;
+  }
+  c->size += consumed;
+  c->request[c->size] = 0;
+  if (c->lines == 2)
+    handle_request(c);
+  else if (c->size == sizeof c->request - 1)
+    send_failure(c->fd, "dimocheck: error: invalid request");
+  else
+    return false;
+  return true;
+}
 
-  CONTINUE_WITH_OUTER_LOOP:;
-  } // End of outer 'for' loop over 'c', 's' and 'v' parts.
+// Clients are answered with a failure if their request lines are not
+// complete after 'REQUEST_TIMEOUT' seconds.  Returns the 'poll' timeout
+// in milliseconds until the next deadline (or '-1' without clients).
 
-  reset_parsing();
-  size_t total_set = positive_values + negative_values;
-  msg("parsed %zu and set %zu values of variables with maximum index '%d'",
-      parsed_values, total_set, maximum_model_variable);
-  msg("set %zu positive %.2f%% and %zu negative values %.2f%%", positive_values,
-      percent(positive_values, total_set), negative_values,
-      percent(negative_values, total_set));
+static int expire_clients(void) {
+  const double now = wall_clock_time();
+  double next = -1;
+  for (size_t i = 0; i != pending_clients;) {
+    struct client *c = clients + i;
+    if (c->deadline <= now) {
+      vrb("request of client timed out");
+      send_failure(c->fd, "dimocheck: error: request timed out");
+      remove_client(c);
+      continue;
+    }
+    if (next < 0 || c->deadline - now < next)
+      next = c->deadline - now;
+    i++;
+  }
+  return next < 0 ? -1 : (int)(1000 * next) + 1;
 }
 
-static void check_model(void) {
-  msg("checking model to satisfy DIMACS formula");
-  if (complete) {
-    msg("checking completeness of model (due to '%s')", complete_option);
-    for (size_t idx = 1; idx <= (size_t)maximum_dimacs_variable; idx++)
-      if (idx >= values.size || !values.begin[idx])
-        die("complete checking mode: "
-            "value for DIMACS variable '%zu' missing",
-            idx);
-    msg("model complete (all DIMACS variables are assigned)");
-  } else
-    msg("partial model checking (without '--complete' nor '--pedantic')");
-  for (struct clause **p = clauses.begin; p != clauses.end; p++) {
-    const struct clause *c = *p;
-    const int *q = c->literals, *end_literals = q + c->size;
-    bool satisfied = false;
-    while (!satisfied && q != end_literals) {
-      const int lit = *q++;
-      assert(lit != INT_MIN);
-      const size_t idx = abs(lit);
-      if (idx >= values.size)
+static void stop_server(int sig) {
+  (void)sig;
+  stop_serving = 1;
+}
+
+static int serve(void) {
+  if (strlen(serve_path) >= sizeof ((struct sockaddr_un *)0)->sun_path)
+    die("socket path '%s' too long", serve_path);
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  strcpy(address.sun_path, serve_path);
+  if ((listening = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+      bind(listening, (struct sockaddr *)&address, sizeof address) ||
+      listen(listening, 128))
+    die("can not serve on socket '%s'", serve_path);
+  const struct sigaction action = {.sa_handler = stop_server};
+  sigaction(SIGINT, &action, 0);
+  sigaction(SIGTERM, &action, 0);
+  signal(SIGPIPE, SIG_IGN);
+  msg("serving checks on socket '%s'", serve_path);
+  struct pollfd *polled = 0;
+  while (!stop_serving) {
+    const int timeout = expire_clients();
+    const size_t count = resident_formulas, waiting = pending_clients;
+    if (!(polled = realloc(polled, (count + waiting + 1) * sizeof *polled)))
+      fatal("out-of-memory reallocating polled descriptors");
+    polled[0] = (struct pollfd){.fd = listening, .events = POLLIN};
+    for (size_t i = 0; i != count; i++)
+      polled[i + 1] =
+          (struct pollfd){.fd = formulas[i].channel, .events = POLLIN};
+    for (size_t i = 0; i != waiting; i++)
+      polled[count + i + 1] =
+          (struct pollfd){.fd = clients[i].fd, .events = POLLIN};
+    if (poll(polled, count + waiting + 1, timeout) < 0) {
+      if (errno == EINTR)
         continue;
-      int value = values.begin[idx];
-      if (value == lit)
-        satisfied = true;
+      fatal("polling server socket failed");
     }
-    if (satisfied)
-      continue;
-    fprintf(stderr, "%s:%zu:%zu: error: clause[%zu] unsatisfied:\n",
-            dimacs_path, c->lineno, c->column, p - clauses.begin + 1);
-    for (q = c->literals; q != end_literals; q++)
-      fprintf(stderr, "%d ", *q);
-    fputs("0\n", stderr);
-    fflush(stderr);
-    exit(1);
+    for (size_t i = 0; i != count; i++) {
+      if (!polled[i + 1].revents)
+        continue;
+      struct formula *formula = formulas;
+      while (formula != formulas + resident_formulas &&
+             formula->channel != polled[i + 1].fd)
+        formula++;
+      if (formula == formulas + resident_formulas)
+        continue;
+      size_t bytes;
+      if (!(polled[i + 1].revents & POLLIN) || formula->ready ||
+          read(formula->channel, &bytes, sizeof bytes) != sizeof bytes) {
+        vrb("formula process of '%s' terminated", formula->path);
+        remove_formula(formula);
+        continue;
+      }
+      formula->ready = true;
+      formula->bytes = bytes;
+      msg("formula '%s' resident (%.0f MB)", formula->path,
+          bytes / (double)(1 << 20));
+      evict_formulas(formula);
+    }
+    for (size_t i = 0; i != waiting; i++) {
+      const struct pollfd *p = polled + count + i + 1;
+      if (!p->revents)
+        continue;
+      struct client *c = clients;
+      while (c != clients + pending_clients && c->fd != p->fd)
+        c++;
+      if (c != clients + pending_clients && receive_request_lines(c))
+        remove_client(c);
+    }
+    if (polled[0].revents & POLLIN)
+      accept_client();
+    while (waitpid(-1, 0, WNOHANG) > 0)
+      ;
   }
-  msg("checked all %zu clauses to be satisfied by model", parsed_clauses);
+  free(polled);
+  msg("stopped serving on socket '%s'", serve_path);
+  while (resident_formulas)
+    remove_formula(formulas);
+  free(formulas);
+  while (pending_clients)
+    remove_client(clients);
+  free(clients);
+  close(listening);
+  unlink(serve_path);
+  while (wait(0) > 0)
+    ;
+  return 0;
 }
 
-static void can_not_combine(const char *a, const char *b) {
-  if (a && b)
-    die("can not combine '%s' and '%s' (try '-h')", a, b);
+// The client of '--connect <socket>' sends absolute paths (and the solution
+// itself if it is '-') and prints the response.  It returns zero only if
+// the response ends with 's MODEL_SATISFIES_FORMULA'.
+
+static void send_path(int server, const char *file_path) {
+  char *absolute = strcmp(file_path, "-") ? realpath(file_path, 0) : 0;
+  if (strcmp(file_path, "-") && !absolute)
+    die("can not find '%s'", file_path);
+  const char *sent = absolute ? absolute : file_path;
+  write_all(server, sent, strlen(sent));
+  write_all(server, "\n", 1);
+  free(absolute);
 }
 
-size_t maximum_resident_set_size(void) {
-  size_t res = 0;
-  struct rusage u;
-  if (!getrusage(RUSAGE_SELF, &u)) {
-    res = (size_t)u.ru_maxrss;
-#ifndef __APPLE__
-    res <<= 10;
-#endif
+static int connect_server(void) {
+  if (strlen(connect_path) >= sizeof ((struct sockaddr_un *)0)->sun_path)
+    die("socket path '%s' too long", connect_path);
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  strcpy(address.sun_path, connect_path);
+  const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0 ||
+      connect(server, (struct sockaddr *)&address, sizeof address))
+    die("can not connect to socket '%s'", connect_path);
+  signal(SIGPIPE, SIG_IGN);
+  send_path(server, dimacs_path);
+  send_path(server, model_path);
+  char chars[1 << 12];
+  ssize_t bytes;
+  if (!strcmp(model_path, "-"))
+    while ((bytes = read(0, chars, sizeof chars)) > 0)
+      write_all(server, chars, bytes);
+  shutdown(server, SHUT_WR);
+  static const char satisfied[] = "s MODEL_SATISFIES_FORMULA\n";
+  char line[sizeof satisfied], last[sizeof satisfied] = {0};
+  size_t len = 0;
+  while ((bytes = read(server, chars, sizeof chars)) > 0) {
+    if (verbosity != INT_MIN)
+      fwrite(chars, 1, bytes, stdout);
+    for (ssize_t i = 0; i != bytes; i++) {
+      if (len + 1 < sizeof line)
+        line[len++] = chars[i];
+      if (chars[i] == '\n') {
+        line[len] = 0, len = 0;
+        strcpy(last, line);
+      }
+    }
   }
+  if (len)
+    last[0] = 0;
+  fflush(stdout);
+  close(server);
+  return strcmp(last, satisfied) ? 1 : 0;
+}
+
+// Options with a value can be given as '--option=<value>' or as separate
+// argument '--option <value>'.  Returns the value if 'argv[*i]' matches.
+
+static const char *option_value(int argc, char **argv, int *i,
+                                const char *name) {
+  const char *arg = argv[*i];
+  const size_t len = strlen(name);
+  if (strncmp(arg, name, len))
+    return 0;
+  if (arg[len] == '=')
+    return arg + len + 1;
+  if (arg[len])
+    return 0;
+  if (*i + 1 == argc)
+    die("argument to '%s' missing (try '-h')", arg);
+  return argv[++*i];
+}
+
+static double follow_seconds(const char *arg) {
+  size_t res = 0;
+  const char *p = arg;
+  do {
+    if ('0' > *p || *p > '9' || res > 1e9)
+      die("invalid argument '%s' to '--follow' (expected seconds)", arg);
+    res = 10 * res + (*p - '0');
+  } while (*++p);
   return res;
 }
 
-static double process_time(void) {
-  double res = 0;
-  struct rusage u;
-  if (!getrusage(RUSAGE_SELF, &u)) {
-    res = u.ru_utime.tv_sec + 1e-6 * u.ru_utime.tv_usec;
-    res += u.ru_stime.tv_sec + 1e-6 * u.ru_stime.tv_usec;
-  }
+static size_t violations_limit(const char *arg) {
+  size_t res = 0;
+  const char *p = arg;
+  do {
+    if (!is_digit(*p) || res > (SIZE_MAX - 9) / 10)
+      die("invalid argument '%s' to '--all-violations' (expected limit)",
+          arg);
+    res = 10 * res + (*p - '0');
+  } while (*++p);
+  return res;
+}
+
+static size_t megabytes(const char *option, const char *arg) {
+  size_t res = 0;
+  const char *p = arg;
+  do
+    if (!is_digit(*p) || res > (SIZE_MAX >> 20) / 10 - 9)
+      die("invalid argument '%s' to '%s' (expected megabytes)", arg, option);
+    else
+      res = 10 * res + (*p - '0');
+  while (*++p);
+  return res << 20;
+}
+
+static unsigned number_of_threads(const char *option, const char *arg) {
+  unsigned res = 0;
+  const char *p = arg;
+  do
+    if (!is_digit(*p) || res > 1000 || !(res = 10 * res + (*p - '0')))
+      die("invalid argument '%s' to '%s' (expected number of threads)", arg,
+          option);
+  while (*++p);
   return res;
 }
 
 int main(int argc, char **argv) {
+  errors = stderr;
   const char *pedantic_option = 0;
   const char *verbose_option = 0;
   const char *debug_option = 0;
   const char *quiet_option = 0;
   const char *silent_option = 0;
   for (int i = 1; i != argc; i++) {
-    const char *arg = argv[i];
+    const char *arg = argv[i], *value;
     if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
       fputs(usage, stdout);
       return 0;
@@ -1131,37 +6097,137 @@ int main(int argc, char **argv) {
       can_not_combine(verbose_option, silent_option);
       can_not_combine(quiet_option, silent_option);
       verbosity = INT_MIN;
-    } else if (arg[0] == '-')
+    } else if (!strcmp(arg, "-m") || !strcmp(arg, "--model-first"))
+      model_first = true;
+    else if (!strcmp(arg, "--pipeline"))
+      pipelined = true;
+    else if (!strcmp(arg, "--compact"))
+      compact = true;
+    else if (!strcmp(arg, "--scalar"))
+      scalar = true;
+    else if (!strcmp(arg, "--all-violations"))
+      violations.enabled = true, violations.limit = SIZE_MAX;
+    else if (!strncmp(arg, "--all-violations=", 17))
+      violations.enabled = true, violations.limit = violations_limit(arg + 17);
+    else if (!strcmp(arg, "--follow"))
+      follow = true;
+    else if (!strncmp(arg, "--follow=", 9))
+      follow = true, follow_limit = follow_seconds(arg + 9);
+    else if ((value = option_value(argc, argv, &i, "--decompress-threads")))
+      decompress_threads = number_of_threads("--decompress-threads", value);
+    else if ((value = option_value(argc, argv, &i, "--parse-threads")))
+      parse_threads = number_of_threads("--parse-threads", value);
+    else if ((value = option_value(argc, argv, &i, "--check-threads")))
+      check_threads = number_of_threads("--check-threads", value);
+    else if ((value = option_value(argc, argv, &i, "--jobs")))
+      jobs = number_of_threads("--jobs", value);
+    else if ((value = option_value(argc, argv, &i, "--cache")))
+      cache_directory = value;
+    else if ((value = option_value(argc, argv, &i, "--manifest")))
+      manifest_path = value;
+    else if ((value = option_value(argc, argv, &i, "--results")))
+      results_path = value;
+    else if ((value = option_value(argc, argv, &i, "--serve-memory")))
+      serve_memory = megabytes("--serve-memory", value);
+    else if ((value = option_value(argc, argv, &i, "--serve")))
+      serve_path = value;
+    else if ((value = option_value(argc, argv, &i, "--connect")))
+      connect_path = value;
+    else if (arg[0] == '-' && arg[1])
       die("invalid option '%s' (try '-h')", arg);
     else if (!dimacs_path)
       dimacs_path = arg;
-    else if (!model_path)
-      model_path = arg;
-    else
-      die("too many files '%s', '%s' and '%s'", dimacs_path, model_path, arg);
+    else {
+      if (!model_path)
+        model_path = arg;
+      push_solution(arg);
+    }
   }
-  if (!dimacs_path)
-    die("DIMACS file missing (try '-h')");
-  if (!model_path)
-    die("model file missing (try '-h')");
+  can_not_combine(manifest_path ? "--manifest" : 0,
+                  serve_path ? "--serve" : 0);
+  can_not_combine(serve_path ? "--serve" : 0,
+                  connect_path ? "--connect" : 0);
+  if (manifest_path || serve_path) {
+    if (dimacs_path)
+      die("can not combine '%s' with files '%s' (try '-h')",
+          manifest_path ? "--manifest" : "--serve", dimacs_path);
+  } else {
+    if (results_path)
+      die("'--results' only works with '--manifest' (try '-h')");
+    if (!dimacs_path)
+      die("DIMACS file missing (try '-h')");
+    if (!model_path)
+      die("model file missing (try '-h')");
+  }
+  if (model_first && cache_directory)
+    die("can not combine '--model-first' and '--cache' (try '-h')");
+  if (model_first && serve_path)
+    die("can not combine '--model-first' and '--serve' (try '-h')");
+  const bool batch = solutions.end - solutions.begin > 1;
+  if (connect_path) {
+    if (batch)
+      die("can not combine '--connect' with several solution files");
+    return connect_server();
+  }
+  if (model_first && batch)
+    die("can not combine '--model-first' with several solution files");
+  if (!manifest_path && !serve_path)
+    stat_dimacs();
   if (verbosity >= 0) {
     msg("DiMoCheck DIMACS Model Checker");
     msg("Copyright (c) 2025, Armin Biere, University of Freiburg");
     msg("Version %s", VERSION);
     msg("Compiled with '%s'", COMPILE);
   }
-  parse_dimacs();
-  parse_model();
-  check_model();
-  if (verbosity != INT_MIN) {
+  if (!manifest_path && !serve_path)
+    require_regular_dimacs();
+  select_classifier();
+  int res = 0;
+  if (manifest_path)
+    res = check_manifest();
+  else if (serve_path)
+    res = serve();
+  else if (model_first)
+    parse_model_first();
+  else {
+    parse_dimacs();
+    if (batch)
+      res = check_models();
+    else {
+      parse_model();
+      check_model();
+    }
+  }
+  if (!batch && !manifest_path && !serve_path && verbosity != INT_MIN) {
     fputs("s MODEL_SATISFIES_FORMULA\n", stdout);
     fflush(stdout);
   }
   free(literals.begin);
-  for (struct clause **p = clauses.begin; p != clauses.end; p++)
-    free(*p);
-  free(clauses.begin);
+  if (cache.image)
+    munmap(cache.image, cache.size);
+  else {
+    free(units.begin);
+    free(binaries.begin);
+    free(ternaries.begin);
+    free(arena.begin);
+    free(offsets.begin);
+    free(kinds.begin);
+    free(compacted.begin);
+    free(checkpoints.begin);
+  }
+  free(cache.path);
+  free(cache.warnings);
+  free(keys.begin);
+  free(positions.begin);
   free(values.begin);
+  free(sparse.table);
+  free(violations.begin);
+  free(violations.literals.begin);
+  free(violations.variables.begin);
+  free(solutions.begin);
+  free_jobs();
+  free(stream_buffer);
+  free(compressed_buffer);
   if (verbosity >= 0) {
     size_t bytes = maximum_resident_set_size();
     if (bytes >= 1u << 30)
@@ -1172,5 +6238,7 @@ int main(int argc, char **argv) {
           bytes / (double)(1 << 20), bytes);
     msg("total process-time %.2f seconds", process_time());
   }
-  return 0;
+  return res;
 }
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef _dimocheck_h_INCLUDED
+#define _dimocheck_h_INCLUDED
+
+#include <stddef.h>
+
+// Library interface for checking models against DIMACS formulas in-process
+// (link with 'libdimocheck.a').  A checker context keeps one parsed formula,
+// which can be parsed from a file or a buffer in memory.  Models are given
+// as solution file, as buffer in solution format ('s' and 'v' lines) or as
+// an array of literals.  Instead of printing diagnostics and exiting, all
+// functions return a status and fill in the (optional) result.
+
+// Contexts are independent.  Calls with different contexts can be made
+// concurrently from different threads, while calls with the same context
+// have to be serialized by the caller.  Library calls parse and check with
+// the calling thread only and without printing messages.
+
+enum dimocheck_status {
+  DIMOCHECK_SATISFIED = 0,   // model satisfies formula (or formula parsed)
+  DIMOCHECK_UNSATISFIED = 1, // unsatisfied clause (or missing value)
+  DIMOCHECK_PARSE_ERROR = 2, // parse error in formula or model
+  DIMOCHECK_ERROR = 3,       // other errors (e.g., file can not be read)
+  DIMOCHECK_FATAL = 4,       // out-of-memory
+};
+
+// Flags for 'dimocheck_init' (same as '--strict' and '--complete').
+
+#define DIMOCHECK_STRICT 1u
+#define DIMOCHECK_COMPLETE 2u
+
+struct dimocheck_result {
+  enum dimocheck_status status;
+  const char *message; // Diagnostics as printed by 'dimocheck' (or "").
+  size_t clause;       // Index of unsatisfied clause (or zero).
+  size_t lineno;       // Line of error or unsatisfied clause (or zero).
+  size_t column;       // Column of error or unsatisfied clause (or zero).
+};
+
+// The 'message' of a result stays valid until the next call with the same
+// context.  The 'name' of buffers is only used in messages.  Contexts stay
+// usable after failed calls (including 'DIMOCHECK_FATAL'), but a failed
+// parse call drops the formula of the context.
+
+typedef struct dimocheck dimocheck;
+
+dimocheck *dimocheck_init(unsigned flags);
+void dimocheck_release(dimocheck *);
+
+int dimocheck_parse_file(dimocheck *, const char *path,
+                         struct dimocheck_result *);
+int dimocheck_parse_buffer(dimocheck *, const char *name, const void *data,
+                           size_t size, struct dimocheck_result *);
+
+int dimocheck_check_file(dimocheck *, const char *path,
+                         struct dimocheck_result *);
+int dimocheck_check_buffer(dimocheck *, const char *name, const void *data,
+                           size_t size, struct dimocheck_result *);
+int dimocheck_check_values(dimocheck *, const int *literals, size_t size,
+                           struct dimocheck_result *);
+
+#endif
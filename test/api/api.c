@@ -0,0 +1,178 @@
+// Test of the library interface in 'dimocheck.h'.  Without arguments the
+// built-in formulas and models in memory are checked, also concurrently
+// with one context per thread.  Otherwise the model
+// file is checked against the DIMACS file with the library (both parsed
+// from files and from memory) and the status is returned as exit code.
+
+#include "dimocheck.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *name = "test/api/api";
+
+static void die(const char *fmt, const char *arg) {
+  fprintf(stderr, "%s: error: ", name);
+  fprintf(stderr, fmt, arg);
+  fputc('\n', stderr);
+  exit(1);
+}
+
+static void expect(int status, const struct dimocheck_result *r,
+                   int expected, size_t lineno, const char *what) {
+  if (status != expected || (int)r->status != expected)
+    die("unexpected status of %s", what);
+  if (lineno && r->lineno != lineno)
+    die("unexpected line of %s", what);
+  if (expected && !*r->message)
+    die("message of %s missing", what);
+}
+
+static void builtin(void) {
+  static const char formula[] = "p cnf 3 3\n1 2 0\n-1 0\n2 -3 0\n";
+  static const char model[] = "s SATISFIABLE\nv -1 2 3 0\n";
+  static const char falsifying[] = "s SATISFIABLE\nv 1 2 0\n";
+  static const char broken[] = "p cnf 1 1\n1 x 0\n";
+  struct dimocheck_result r;
+  dimocheck *d = dimocheck_init(0), *e = dimocheck_init(DIMOCHECK_COMPLETE);
+  if (!d || !e)
+    die("%s", "could not initialize checker");
+  int res = dimocheck_check_values(d, (int[]){1}, 1, &r);
+  expect(res, &r, DIMOCHECK_ERROR, 0, "check without formula");
+  res = dimocheck_parse_buffer(d, "formula", formula, strlen(formula), &r);
+  expect(res, &r, DIMOCHECK_SATISFIED, 0, "parsing formula");
+  res = dimocheck_parse_buffer(e, "formula", formula, strlen(formula), &r);
+  expect(res, &r, DIMOCHECK_SATISFIED, 0, "parsing formula again");
+  res = dimocheck_check_buffer(d, "model", model, strlen(model), &r);
+  expect(res, &r, DIMOCHECK_SATISFIED, 0, "satisfying model");
+  res = dimocheck_check_buffer(d, "model", falsifying, strlen(falsifying),
+                               &r);
+  expect(res, &r, DIMOCHECK_UNSATISFIED, 3, "falsifying model");
+  if (r.clause != 2)
+    die("%s", "unexpected unsatisfied clause");
+  res = dimocheck_check_values(d, (int[]){-1, 2}, 2, &r);
+  expect(res, &r, DIMOCHECK_SATISFIED, 0, "satisfying values");
+  res = dimocheck_check_values(e, (int[]){-1, 2}, 2, &r);
+  expect(res, &r, DIMOCHECK_UNSATISFIED, 0, "incomplete values");
+  res = dimocheck_check_values(e, (int[]){-1, 2, -3}, 3, &r);
+  expect(res, &r, DIMOCHECK_SATISFIED, 0, "complete values");
+  res = dimocheck_check_values(d, (int[]){1, -1}, 2, &r);
+  expect(res, &r, DIMOCHECK_PARSE_ERROR, 0, "inconsistent values");
+  res = dimocheck_check_values(d, (int[]){1, 2}, 2, &r);
+  expect(res, &r, DIMOCHECK_UNSATISFIED, 3, "falsifying values");
+  res = dimocheck_parse_buffer(e, "broken", broken, strlen(broken), &r);
+  expect(res, &r, DIMOCHECK_PARSE_ERROR, 2, "broken formula");
+  res = dimocheck_check_values(e, (int[]){1}, 1, &r);
+  expect(res, &r, DIMOCHECK_ERROR, 0, "check after broken formula");
+  res = dimocheck_check_buffer(d, "model", model, strlen(model), &r);
+  expect(res, &r, DIMOCHECK_SATISFIED, 0, "satisfying model again");
+  dimocheck_release(d);
+  dimocheck_release(e);
+}
+
+// Each thread parses its own formula with a unit clause on its own variable
+// and checks it repeatedly.  Mixing up the formulas of contexts (or the
+// models of threads) changes the statuses or the unsatisfied clauses.
+
+#define THREADS 4
+#define ROUNDS 1000
+
+static void *concurrent(void *arg) {
+  const int unit = 1 + (int)(size_t)arg, other = unit + THREADS;
+  char formula[64];
+  snprintf(formula, sizeof formula, "p cnf %d 2\n%d 0\n-%d %d 0\n", other,
+           unit, unit, other);
+  struct dimocheck_result r;
+  dimocheck *d = dimocheck_init(DIMOCHECK_STRICT);
+  if (!d)
+    die("%s", "could not initialize checker");
+  for (int round = 0; round != ROUNDS; round++) {
+    int res;
+    if (!(round % 10)) {
+      res = dimocheck_parse_buffer(d, "formula", formula, strlen(formula),
+                                   &r);
+      expect(res, &r, DIMOCHECK_SATISFIED, 0, "parsing formula concurrently");
+    }
+    res = dimocheck_check_values(d, (int[]){unit, other}, 2, &r);
+    expect(res, &r, DIMOCHECK_SATISFIED, 0, "satisfying values concurrently");
+    res = dimocheck_check_values(d, (int[]){unit, -other}, 2, &r);
+    expect(res, &r, DIMOCHECK_UNSATISFIED, 3,
+           "falsifying values concurrently");
+    if (r.clause != 2)
+      die("%s", "unexpected unsatisfied clause concurrently");
+    res = dimocheck_check_values(d, (int[]){-unit}, 1, &r);
+    expect(res, &r, DIMOCHECK_UNSATISFIED, 2, "falsified unit concurrently");
+    if (r.clause != 1)
+      die("%s", "unexpected unsatisfied unit concurrently");
+  }
+  dimocheck_release(d);
+  return 0;
+}
+
+static void threads(void) {
+  pthread_t thread[THREADS];
+  for (size_t i = 0; i != THREADS; i++)
+    if (pthread_create(thread + i, 0, concurrent, (void *)i))
+      die("%s", "could not create thread");
+  for (size_t i = 0; i != THREADS; i++)
+    pthread_join(thread[i], 0);
+}
+
+static char *slurp(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    die("can not read '%s'", path);
+  char *data = 0;
+  size_t bytes = 0, capacity = 0, read;
+  do {
+    if (bytes == capacity) {
+      capacity = capacity ? 2 * capacity : 1 << 16;
+      if (!(data = realloc(data, capacity)))
+        die("%s", "out-of-memory");
+    }
+    read = fread(data + bytes, 1, capacity - bytes, file);
+    bytes += read;
+  } while (read);
+  fclose(file);
+  *size = bytes;
+  return data;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 1) {
+    builtin();
+    threads();
+    return 0;
+  }
+  unsigned flags = 0;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+    if (!strcmp(argv[i], "-s"))
+      flags |= DIMOCHECK_STRICT;
+    else if (!strcmp(argv[i], "-c"))
+      flags |= DIMOCHECK_COMPLETE;
+    else
+      die("invalid option '%s'", argv[i]);
+  if (argc - i != 2)
+    die("%s", "expected DIMACS and model file");
+  const char *dimacs = argv[i], *model = argv[i + 1];
+  dimocheck *d = dimocheck_init(flags);
+  struct dimocheck_result r;
+  int res = dimocheck_parse_file(d, dimacs, &r);
+  if (!res)
+    res = dimocheck_check_file(d, model, &r);
+  size_t dimacs_size, model_size;
+  char *dimacs_data = slurp(dimacs, &dimacs_size);
+  char *model_data = slurp(model, &model_size);
+  int other = dimocheck_parse_buffer(d, dimacs, dimacs_data, dimacs_size, 0);
+  if (!other)
+    other = dimocheck_check_buffer(d, model, model_data, model_size, 0);
+  if (other != res)
+    die("checking '%s' in memory differs", model);
+  free(dimacs_data);
+  free(model_data);
+  dimocheck_release(d);
+  return res;
+}
@@ -0,0 +1,32 @@
+#!/bin/sh
+path=test/api
+name=$path/run.sh
+die () {
+  echo "$name: error: $*" 1>&2
+  exit 1
+}
+cd `dirname $0` || exit 1
+cd ../.. || exit 1
+binary=./$path/api
+[ -f $binary ] || die "could not find '$binary'"
+echo "[running '$name']"
+$binary || die "'$binary' failed"
+for cnf in test/check/complete/good/*.cnf
+do
+  sol=`dirname $cnf`/`basename $cnf .cnf`.sol
+  $binary -c $cnf $sol || die "'$binary -c $cnf $sol' failed"
+done
+for cnf in test/check/complete/bad/*.cnf test/check/partial/bad/*.cnf
+do
+  sol=`dirname $cnf`/`basename $cnf .cnf`.sol
+  $binary -c $cnf $sol && die "'$binary -c $cnf $sol' unexpectedly succeeded"
+done
+for cnf in test/parse/strict/bad/*.cnf
+do
+  sol=`dirname $cnf`/`basename $cnf .cnf`.sol
+  $binary -s $cnf $sol && \
+    die "'$binary -s $cnf $sol' unexpectedly succeeded in strict mode"
+  $binary $cnf $sol || \
+    die "'$binary $cnf $sol' unexpectedly failed in relaxed mode"
+done
+exit 0
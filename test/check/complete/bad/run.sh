@@ -19,4 +19,35 @@ do
     die "'dimocheck $args -c' unexpectedly succeeded in complete mode"
   $binary $args 1>/dev/null 2>/dev/null || \
     die "'dimocheck $args' unexpectedly failed in partial mode"
+  $binary $args -c -m 1>/dev/null 2>/dev/null && \
+    die "'dimocheck $args -c -m' unexpectedly succeeded in complete mode"
+  $binary $args -c --all-violations 1>/dev/null 2>/dev/null && \
+    die "'dimocheck $args -c --all-violations' unexpectedly succeeded in complete mode"
+  $binary $args --all-violations 1>/dev/null 2>/dev/null || \
+    die "'dimocheck $args --all-violations' unexpectedly failed in partial mode"
+  $binary $args -m 1>/dev/null 2>/dev/null || \
+    die "'dimocheck $args -m' unexpectedly failed in partial mode"
 done
+
+# Missing values reported by '--all-violations' in complete mode.
+
+tmp=`mktemp -d` || die "could not create temporary directory"
+trap "rm -rf $tmp" 0
+expect () {
+  cat > $tmp/expected
+  $binary -q -c "$@" 1>/dev/null 2>$tmp/output && \
+    die "'dimocheck -q -c $*' unexpectedly succeeded"
+  cmp -s $tmp/expected $tmp/output || \
+    die "'dimocheck -q -c $*' unexpected output:" \
+      "`diff $tmp/expected $tmp/output | head -4`"
+}
+expect $path/partial1.cnf $path/partial1.sol --all-violations <<END
+dimocheck: error: complete checking mode: value for DIMACS variable '2' missing
+dimocheck: error: one value of a DIMACS variable missing (1 reported)
+END
+expect $path/partial2.cnf $path/partial2.sol --all-violations=2 <<END
+dimocheck: error: complete checking mode: value for DIMACS variable '1' missing
+dimocheck: error: complete checking mode: value for DIMACS variable '3' missing
+dimocheck: error: 6 values of DIMACS variables missing (2 reported)
+END
+exit 0
@@ -0,0 +1,9 @@
+s SATISFIABLE
+v 1 -2 3 -4 5 -6 7 -8 9 -10
+v 11 -12 13 -14 15 -16 17 -18 19 -20
+v 21 -22 23 -24 25 -26 27 -28 29 -30
+v 31 -32 -34 35 -36 37 -38 39 -40 41
+v -42 43 -44 45 -46 47 -48 49 -50 51
+v -52 53 -54 55 -56 57 -58 59 -60 61
+v -62 63 -64 65 -66 67 -68 69 -70
+v 0
@@ -10,10 +10,96 @@ cd ../../../.. || exit 1
 binary=./dimocheck
 [ -f $binary ] || die "could not find 'dimocheck'"
 echo "[running '$name']"
+cache=`mktemp -d` || die "could not create cache directory"
+trap "rm -rf $cache" 0
 for cnf in $path/*.cnf
 do
   sol=$path/`basename $cnf .cnf`.sol
   [ -f $sol ] || die "could not find '$sol'"
   args="$cnf $sol -q -c"
   $binary $args 1>/dev/null || die "'dimocheck $args' failed"
+  $binary $args --pipeline 1>/dev/null || \
+    die "'dimocheck $args --pipeline' failed"
+  $binary $args --compact 1>/dev/null || \
+    die "'dimocheck $args --compact' failed"
+  $binary $args --check-threads 2 1>/dev/null || \
+    die "'dimocheck $args --check-threads 2' failed"
+  $binary $cnf $sol $sol -q -c --jobs 2 1>/dev/null || \
+    die "'dimocheck $cnf $sol $sol -q -c --jobs 2' failed"
+  for round in parsed cached
+  do
+    $binary $args --cache $cache 1>/dev/null || \
+      die "'dimocheck $args --cache $cache' failed ($round)"
+  done
+  $binary $cnf - -q -c <$sol 1>/dev/null || \
+    die "'dimocheck $cnf - -q -c <$sol' failed"
+  cat $sol | $binary $cnf /dev/fd/0 -q -c 1>/dev/null || \
+    die "'cat $sol | dimocheck $cnf /dev/fd/0 -q -c' failed"
+  growing=$cache/growing.sol
+  rm -f $growing
+  (sleep 0.1; head -n 1 $sol; sleep 0.1; tail -n +2 $sol) > $growing &
+  $binary $cnf $growing -q -c --follow=10 1>/dev/null || \
+    die "'dimocheck $cnf $growing -q -c --follow=10' failed"
+  wait
+  args="$args --model-first"
+  $binary $args 1>/dev/null || die "'dimocheck $args' failed"
+  $binary $args --pipeline 1>/dev/null || \
+    die "'dimocheck $args --pipeline' failed"
+done
+manifest=$cache/manifest
+for cnf in $path/*.cnf
+do
+  echo "$cnf $path/`basename $cnf .cnf`.sol"
+done > $manifest
+quoted=$cache/quoted,\"name.cnf
+cp $path/true.cnf "$quoted" || die "could not copy '$path/true.cnf'"
+echo "$quoted $path/true.sol" >> $manifest
+results=$cache/results
+$binary --manifest $manifest -q -c --jobs 2 --results $results 1>/dev/null || \
+  die "'dimocheck --manifest $manifest -q -c --jobs 2' failed"
+
+# The results are in manifest order (even though jobs are sorted by size)
+# with quoted paths, times with three decimals and the resident set size
+# in bytes (which is more than one megabyte for every process).
+
+header="dimacs,solution,status,error,parse_seconds,check_seconds,\
+maximum_resident_set_size"
+[ "`head -n 1 $results`" = "$header" ] || \
+  die "unexpected header in '$results': '`head -n 1 $results`'"
+[ `wc -l < $results` = `expr \`wc -l < $manifest\` + 1` ] || \
+  die "unexpected number of lines in '$results'"
+csv () {
+  escaped=`printf '%s' "$1" | sed -e 's,","",g'`
+  printf '"%s"' "$escaped"
+}
+line=1
+while read cnf sol
+do
+  line=`expr $line + 1`
+  result=`sed -n -e "${line}p" $results`
+  prefix="`csv "$cnf"`,`csv "$sol"`,MODEL_SATISFIES_FORMULA,\"\","
+  rest=${result#"$prefix"}
+  [ "$rest" != "$result" ] || \
+    die "unexpected line $line in '$results': '$result'"
+  echo "$rest" | grep -q -E '^[0-9]+\.[0-9]{3},[0-9]+\.[0-9]{3},[0-9]+$' || \
+    die "unexpected times or size in line $line of '$results': '$rest'"
+  [ ${rest##*,} -ge 1048576 ] || \
+    die "resident set size '${rest##*,}' in '$results' not in bytes"
+done < $manifest
+socket=$cache/socket
+$binary --serve $socket -q -c 1>/dev/null 2>/dev/null &
+server=$!
+trap "kill $server 2>/dev/null; rm -rf $cache" 0
+while [ ! -S $socket ]
+do
+  kill -0 $server 2>/dev/null || die "'dimocheck --serve $socket' failed"
+  sleep 0.1
+done
+for cnf in $path/*.cnf
+do
+  sol=$path/`basename $cnf .cnf`.sol
+  $binary --connect $socket $cnf $sol 1>/dev/null || \
+    die "'dimocheck --connect $socket $cnf $sol' failed"
+  $binary --connect $socket $cnf - <$sol 1>/dev/null || \
+    die "'dimocheck --connect $socket $cnf - <$sol' failed"
 done
@@ -0,0 +1,24 @@
+#!/bin/sh
+path=test/check/compressed/good
+name=$path/run.sh
+die () {
+  echo "$name: error: $*" 1>&2
+  exit 1
+}
+cd `dirname $0` || exit 1
+cd ../../../.. || exit 1
+binary=./dimocheck
+[ -f $binary ] || die "could not find 'dimocheck'"
+echo "[running '$name']"
+for cnf in $path/*.cnf.*
+do
+  base=$path/`basename $cnf | sed -e 's/\.cnf\..*//'`
+  sol=`ls $base.sol* 2>/dev/null | head -1`
+  [ -f "$sol" ] || die "could not find solution for '$cnf'"
+  args="$cnf $sol -q -c"
+  $binary $args 1>/dev/null || die "'dimocheck $args' failed"
+  args="$args --decompress-threads 2"
+  $binary $args 1>/dev/null || die "'dimocheck $args' failed"
+  args="$args --pipeline"
+  $binary $args 1>/dev/null || die "'dimocheck $args' failed"
+done
@@ -0,0 +1,2 @@
+s SATISFIABLE
+v 0
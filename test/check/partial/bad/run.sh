@@ -10,6 +10,8 @@ cd ../../../.. || exit 1
 binary=./dimocheck
 [ -f $binary ] || die "could not find 'dimocheck'"
 echo "[running '$name']"
+cache=`mktemp -d` || die "could not create cache directory"
+trap "rm -rf $cache" 0
 for cnf in $path/*.cnf
 do
   sol=$path/`basename $cnf .cnf`.sol
@@ -17,5 +19,84 @@ do
   args="$cnf $sol -q"
   $binary $args 1>/dev/null 2>/dev/null && \
     die "'dimocheck $args' unexpectedly succeeded"
+  $binary $args --compact 1>/dev/null 2>/dev/null && \
+    die "'dimocheck $args --compact' unexpectedly succeeded"
+  $binary $args --all-violations 1>/dev/null 2>/dev/null && \
+    die "'dimocheck $args --all-violations' unexpectedly succeeded"
+  $binary $args --all-violations=1 --compact 1>/dev/null 2>/dev/null && \
+    die "'dimocheck $args --all-violations=1 --compact' unexpectedly succeeded"
+  $binary $cnf $sol $sol -q --jobs 2 1>/dev/null 2>/dev/null && \
+    die "'dimocheck $cnf $sol $sol -q --jobs 2' unexpectedly succeeded"
+  for round in parsed cached
+  do
+    $binary $args --cache $cache 1>/dev/null 2>/dev/null && \
+      die "'dimocheck $args --cache $cache' unexpectedly succeeded ($round)"
+  done
+  $binary /dev/stdin $sol -q <$cnf 1>/dev/null 2>/dev/null && \
+    die "'dimocheck /dev/stdin $sol -q <$cnf' unexpectedly succeeded"
+done
+
+# Compares the error output of '--all-violations' with the expected one
+# given on '<stdin>' (with and without compact clauses).
+
+expect () {
+  cat > $cache/expected
+  for compact in "" --compact
+  do
+    $binary -q "$@" $compact 1>/dev/null 2>$cache/output && \
+      die "'dimocheck -q $* $compact' unexpectedly succeeded"
+    cmp -s $cache/expected $cache/output || \
+      die "'dimocheck -q $* $compact' unexpected output:" \
+        "`diff $cache/expected $cache/output | head -4`"
+  done
+}
+
+expect $path/kinds.cnf $path/kinds.sol --all-violations <<END
+$path/kinds.cnf:5:1: error: clause[4] unsatisfied:
+-2 3 4 5 0
+$path/kinds.cnf:6:1: error: clause[5] unsatisfied:
+3 4 5 0
+dimocheck: error: 2 unsatisfied clauses (2 reported)
+dimocheck: error: one unsatisfied clause of size 3
+dimocheck: error: one unsatisfied clause of size 4
+END
+expect $path/false.cnf $path/false.sol --all-violations <<END
+$path/false.cnf:2:1: error: clause[1] unsatisfied:
+0
+dimocheck: error: one unsatisfied clause (1 reported)
+dimocheck: error: one unsatisfied clause of size 0
+END
+expect $path/long.cnf $path/long.sol --all-violations=3 <<END
+$path/long.cnf:2:1: error: clause[1] unsatisfied:
+-1 -2 -3 -4 -5 -6 -7 -8 -9 -10 -11 -12 -13 -14 -15 -16 -17 -18 -19 -20 0
+$path/long.cnf:3:1: error: clause[2] unsatisfied:
+-1 -2 -3 -4 -5 -6 -7 -8 -9 -10 -11 -12 -13 -14 -15 -16 -17 0
+$path/long.cnf:4:1: error: clause[3] unsatisfied:
+-1 -2 0
+dimocheck: error: 5 unsatisfied clauses (3 reported)
+dimocheck: error: 2 unsatisfied clauses of size 2
+dimocheck: error: 3 unsatisfied clauses of size 16 to 31
+END
+manifest=$cache/manifest
+for cnf in $path/*.cnf
+do
+  echo "$cnf $path/`basename $cnf .cnf`.sol"
+done > $manifest
+$binary --manifest $manifest -q --jobs 2 1>/dev/null 2>/dev/null && \
+  die "'dimocheck --manifest $manifest -q --jobs 2' unexpectedly succeeded"
+socket=$cache/socket
+$binary --serve $socket -q 1>/dev/null 2>/dev/null &
+server=$!
+trap "kill $server 2>/dev/null; rm -rf $cache" 0
+while [ ! -S $socket ]
+do
+  kill -0 $server 2>/dev/null || die "'dimocheck --serve $socket' failed"
+  sleep 0.1
+done
+for cnf in $path/*.cnf
+do
+  sol=$path/`basename $cnf .cnf`.sol
+  $binary --connect $socket $cnf $sol 1>/dev/null && \
+    die "'dimocheck --connect $socket $cnf $sol' unexpectedly succeeded"
 done
 exit 0
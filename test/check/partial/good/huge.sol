@@ -0,0 +1,2 @@
+s SATISFIABLE
+v 1 2147483000 -3 0
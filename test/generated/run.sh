@@ -0,0 +1,121 @@
+#!/bin/sh
+# Checks large formulas generated by 'bench/generate', which are parsed in
+# several chunks with '--parse-threads' and checked in several blocks with
+# '--check-threads'.  The output has to be identical to parsing and
+# checking with one thread, also with faults injected into clause lines at
+# the beginning, middle and end of the formula and with wrong models.
+path=test/generated
+name=$path/run.sh
+die () {
+  echo "$name: error: $*" 1>&2
+  exit 1
+}
+cd `dirname $0` || exit 1
+cd ../.. || exit 1
+binary=./dimocheck
+generate=./bench/generate
+[ -f $binary ] || die "could not find 'dimocheck'"
+[ -f $generate ] || die "could not find '$generate'"
+echo "[running '$name']"
+tmp=`mktemp -d` || die "could not create temporary directory"
+trap "rm -rf $tmp" 0
+cnf=$tmp/formula.cnf
+sol=$tmp/formula.sol
+$generate --size 4M --seed 4 $cnf $sol 1>/dev/null || \
+  die "'$generate --size 4M --seed 4 $cnf $sol' failed"
+$binary -v --parse-threads 4 $cnf $sol 2>&1 | \
+  grep -q "parsing clauses in [2-9] chunks" || \
+  die "'dimocheck -v --parse-threads 4 $cnf $sol' did not parse in chunks"
+
+# Strict parsing requires all values in one 'v' line.
+
+strict=$tmp/strict.sol
+{
+  echo "s SATISFIABLE"
+  echo "v `sed -n -e 's,^v ,,p' $sol | tr '\n' ' ' | sed -e 's, 0 *$,,'` 0"
+} > $strict
+
+# Compares exit code and output with and without the given threads.
+
+compare () {
+  threads=$1
+  formula=$2
+  shift 2
+  $binary "$@" $formula > $tmp/sequential 2>&1
+  sequential=$?
+  $binary $threads 4 "$@" $formula > $tmp/parallel 2>&1
+  parallel=$?
+  [ $sequential = $parallel ] || \
+    die "'dimocheck $threads 4 $* $formula' exit code $parallel" \
+      "differs from $sequential without threads"
+  cmp -s $tmp/sequential $tmp/parallel || \
+    die "'dimocheck $threads 4 $* $formula' output differs:" \
+      "`diff $tmp/sequential $tmp/parallel | head -4`"
+}
+
+compare --parse-threads $cnf $sol
+compare --parse-threads $cnf $strict -s
+compare --parse-threads $cnf $sol -c
+compare --parse-threads $cnf $sol --all-violations
+
+# Each fault is injected into one clause line at a time.  The unit clause
+# with the negation of the first value is falsified by the model.
+
+lines=`wc -l < $cnf`
+unit=`sed -n -e 's,^v \(-*[0-9]*\) .*,\1,p' $sol | head -1 | \
+  sed -e 's,^-,,;t;s,^,-,'`
+for line in 2 `expr $lines / 2` $lines
+do
+  for fault in \
+    "s,^,x ," \
+    "s, 0$,  0," \
+    "s, 0$,," \
+    "s,^,2147483647 ," \
+    "s,^,-0 ," \
+    "s,^.*$,$unit 0,"
+  do
+    faulty=$tmp/faulty.cnf
+    sed -e "${line}$fault" $cnf > $faulty
+    cmp -s $cnf $faulty && die "fault '$fault' not injected at line $line"
+    compare --parse-threads $faulty $sol
+    compare --parse-threads $faulty $strict -s
+    compare --parse-threads $faulty $sol --all-violations
+  done
+done
+
+# Blocks of 16384 clauses of each kind (binary, ternary and longer) are
+# checked concurrently.  The model with every 997th value flipped falsifies
+# clauses in all blocks, while the others falsify a single clause late in
+# the formula.  The first unsatisfied clause has to be the same.
+
+cnf=$tmp/blocks.cnf
+sol=$tmp/blocks.sol
+$generate --clauses 400000 --seed 5 $cnf $sol 1>/dev/null || \
+  die "'$generate --clauses 400000 --seed 5 $cnf $sol' failed"
+$binary -v --check-threads 4 $cnf $sol 2>&1 | \
+  grep -q "checking [0-9]* blocks of clauses with 4 threads" || \
+  die "'dimocheck -v --check-threads 4 $cnf $sol' did not check in blocks"
+flipped=$tmp/flipped.sol
+awk '/^v/ { for (i = 2; i <= NF; i++)
+              if ($i && ($i < 0 ? -$i : $i) % 997 == 0) $i = -$i }
+     { print }' $sol > $flipped
+cmp -s $sol $flipped && die "no values flipped in '$flipped'"
+lines=`wc -l < $cnf`
+set -- `sed -n -e 's,^v \(-*[0-9]*\) \(-*[0-9]*\) \(-*[0-9]*\) .*,\1 \2 \3,p' \
+  $sol | head -1 | sed -e 's,\(-*\)\([0-9]*\),X\1\2,g;s,X-,,g;s,X,-,g'`
+falsified="$1 $2 $3 0"
+last=$tmp/last.cnf
+sed -e "${lines}s,^.*$,$falsified," $cnf > $last
+both=$tmp/both.cnf
+sed -e "`expr $lines - 1`s,^.*$,$1 $2 0,;${lines}s,^.*$,$falsified," \
+  $cnf > $both
+for formula in $cnf $last $both
+do
+  for model in $sol $flipped
+  do
+    compare --check-threads $formula $model
+    compare --check-threads $formula $model --compact
+    compare --check-threads $formula $model --all-violations=100
+  done
+done
+exit 0
@@ -0,0 +1,3 @@
+s SATISFIABLE
+v 1 2147483000 -3
+v -2147483000 0